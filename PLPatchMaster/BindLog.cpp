@@ -0,0 +1,154 @@
+/*
+ * Author: Landon Fuller <landon@landonf.org>
+ *
+ * Copyright (c) 2015 Landon Fuller <landon@landonf.org>.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "BindLog.hpp"
+#include "BindSiteWriter.hpp"
+#include "PMLog.h"
+
+namespace patchmaster {
+
+/**
+ * Write the patched @a value to @a address, recording the value previously held at the bind site.
+ *
+ * The site is logged even if it already holds @a value (e.g. an earlier patch bound the same replacement), as
+ * this patch must then continue to own the site if the earlier patch is removed. Rewriting a site that this log
+ * has already recorded is not logged again.
+ *
+ * The value is published with an atomic release store. The page containing @a address must be writable; see
+ * BindSiteWriter.
+ *
+ * @param image The base address of the image containing @a address.
+ * @param address The bind address.
+ * @param value The patched value.
+ *
+ * @return Returns false if the log has been retired, in which case no write is performed.
+ */
+bool BindLog::write (const void *image, uintptr_t *address, uintptr_t value) {
+    std::lock_guard<std::mutex> guard(_lock);
+    if (_retired)
+        return false;
+
+    auto &sites = _images[image];
+    if (*address == value) {
+        for (auto &&site : sites) {
+            if (site.address == address)
+                return true;
+        }
+    }
+
+    sites.push_back(entry { address, *address });
+    BindSiteWriter::store(address, value);
+
+    return true;
+}
+
+/**
+ * If this log records that @a address was overwritten while holding @a replaced, update the
+ * entry to instead restore @a original. This is used to remove an earlier patch from the chain
+ * of values that have been written to a bind site.
+ *
+ * @param image The base address of the image containing @a address.
+ * @param address The bind address.
+ * @param replaced The original value to be replaced.
+ * @param original The new original value.
+ *
+ * @return Returns true if a matching entry was found and updated.
+ */
+bool BindLog::splice (const void *image, uintptr_t *address, uintptr_t replaced, uintptr_t original) {
+    std::lock_guard<std::mutex> guard(_lock);
+    auto sites = _images.find(image);
+    if (sites == _images.end())
+        return false;
+
+    for (auto &&site : sites->second) {
+        if (site.address == address && site.original == replaced) {
+            site.original = original;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Restore all logged bind sites that still hold the patched @a value, in reverse order, and retire the log.
+ *
+ * @param value The patched value.
+ * @param superseded Called for each logged site prior to its restoration. If the site has since been
+ * overwritten by a later patch -- including one that wrote the same @a value -- the callback must hand the
+ * site's original value to that patch and return true; the site is then not modified. The callback must not
+ * call back into this log.
+ */
+void BindLog::restore (uintptr_t value, const superseded_fn &superseded) {
+    std::lock_guard<std::mutex> guard(_lock);
+    _retired = true;
+
+    /* Make all logged sites writable */
+    BindSiteWriter writer;
+    for (auto &&image : _images) {
+        for (auto &&site : image.second)
+            writer.add(site.address);
+    }
+    bool writable = writer.begin();
+    if (!writable)
+        PMLog("Failed to make all logged bind sites writable; sites on read-only pages will not be restored");
+
+    for (auto &&image : _images) {
+        auto &sites = image.second;
+        for (auto site = sites.rbegin(); site != sites.rend(); site++) {
+            if (superseded(image.first, *site))
+                continue;
+
+            if (*site->address != value)
+                continue;
+
+            /* Skip sites that we could not make writable; the site will continue to reference the patched value */
+            if (!writable && !writer.writable(site->address)) {
+                PMLog("Skipping restoration of read-only bind site %p in image %p", (void *) site->address, image.first);
+                continue;
+            }
+
+            BindSiteWriter::store(site->address, site->original);
+        }
+    }
+
+    _images.clear();
+}
+
+/**
+ * Discard all entries for @a image. This must be called when an image is unloaded, prior to any
+ * later restore.
+ *
+ * @param image The base address of the unloaded image.
+ */
+void BindLog::purge (const void *image) {
+    std::lock_guard<std::mutex> guard(_lock);
+    _images.erase(image);
+}
+
+} /* namespace patchmaster */
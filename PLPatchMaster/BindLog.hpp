@@ -0,0 +1,82 @@
+/*
+ * Author: Landon Fuller <landon@landonf.org>
+ *
+ * Copyright (c) 2015 Landon Fuller <landon@landonf.org>.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace patchmaster {
+
+/**
+ * A log of the bind sites overwritten by a single symbol patch, grouped by the image to which they belong.
+ *
+ * The log allows a patch to be reverted by replaying the recorded original values directly, without
+ * re-evaluating any image's bind opcodes. All bind site writes performed on behalf of the patch are made
+ * through its log; once the log has been restored, the patch is retired and no further writes will be
+ * performed. This ensures that a patch that is concurrently being applied from a stale patch table
+ * snapshot can not overwrite a bind site after the patch has been removed.
+ *
+ * This class is thread-safe.
+ */
+class BindLog {
+public:
+    /** A single overwritten bind site. */
+    struct entry {
+        /** The bind address. */
+        uintptr_t *address;
+
+        /** The value held at the bind address prior to patching. */
+        uintptr_t original;
+    };
+
+    /** A function called for each logged bind site prior to restoration; returns true if the site has been
+     * superseded by a later patch, and must not be restored. */
+    typedef std::function<bool(const void *image, const entry &site)> superseded_fn;
+
+    bool write (const void *image, uintptr_t *address, uintptr_t value);
+    bool splice (const void *image, uintptr_t *address, uintptr_t replaced, uintptr_t original);
+    void restore (uintptr_t value, const superseded_fn &superseded);
+    void purge (const void *image);
+
+private:
+    /** Lock that must be held when accessing _images or _retired. */
+    std::mutex _lock;
+
+    /** True if this log has been restored, and no further writes may be performed. */
+    bool _retired = false;
+
+    /** All logged bind sites, keyed by image header address, in the order they were written. */
+    std::unordered_map<const void *, std::vector<entry>> _images;
+};
+
+} /* namespace patchmaster */
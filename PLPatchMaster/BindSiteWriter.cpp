@@ -0,0 +1,268 @@
+/*
+ * Author: Landon Fuller <landon@landonf.org>
+ *
+ * Copyright (c) 2015 Landon Fuller <landon@landonf.org>.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "BindSiteWriter.hpp"
+#include "PMLog.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+
+#ifdef __APPLE__
+#include <mach/mach.h>
+#elif defined(__linux__)
+#include <limits.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#endif
+
+namespace patchmaster {
+
+#ifdef __APPLE__
+/** Native page protection flags. */
+typedef vm_prot_t protection_t;
+static const protection_t PROTECTION_WRITE = VM_PROT_WRITE;
+#elif defined(__linux__)
+/** Native page protection flags. */
+typedef int protection_t;
+static const protection_t PROTECTION_WRITE = PROT_WRITE;
+#endif
+
+/** The protection state of a single page that has been made writable by one or more writers. */
+struct page_state {
+    /** Number of open writers that include this page. */
+    size_t refs;
+
+    /** The page's protection prior to being made writable. */
+    protection_t protection;
+
+    /** True if the page's protection was modified, and must be restored. */
+    bool changed;
+
+    /** True if the page could not be made writable. This is reported to every writer that includes the page. */
+    bool failed;
+};
+
+/** Lock that must be held when accessing open_pages, or modifying the protection of any page in open_pages. */
+static std::mutex open_pages_lock;
+
+/** All pages included in an open writer, keyed by page address. */
+static std::unordered_map<uintptr_t, page_state> *open_pages = new std::unordered_map<uintptr_t, page_state>();
+
+/** A range of mapped pages sharing a single protection. */
+struct mapped_region {
+    uintptr_t start;
+    uintptr_t end;
+    protection_t protection;
+};
+
+/**
+ * Look up the protection of the page at @a page, populating @a region with the enclosing region.
+ *
+ * @param page The page address.
+ * @param region On success, the mapped region containing @a page.
+ */
+static bool query_region (uintptr_t page, mapped_region *region) {
+#ifdef __APPLE__
+    vm_address_t addr = page;
+    vm_size_t size;
+    vm_region_basic_info_data_64_t info;
+    mach_msg_type_number_t count = VM_REGION_BASIC_INFO_COUNT_64;
+    mach_port_t object;
+
+    kern_return_t kr = vm_region_64(mach_task_self(), &addr, &size, VM_REGION_BASIC_INFO_64, (vm_region_info_t) &info, &count, &object);
+    if (kr != KERN_SUCCESS || addr > page)
+        return false;
+
+    *region = mapped_region { addr, addr + size, info.protection };
+    return true;
+#elif defined(__linux__)
+    FILE *maps = fopen("/proc/self/maps", "r");
+    if (maps == NULL)
+        return false;
+
+    bool found = false;
+    unsigned long start, end;
+    char perms[5];
+    char line[PATH_MAX + 128];
+    while (fgets(line, sizeof(line), maps) != NULL) {
+        if (sscanf(line, "%lx-%lx %4s", &start, &end, perms) != 3)
+            continue;
+
+        if (page < start || page >= end)
+            continue;
+
+        protection_t prot = PROT_NONE;
+        if (perms[0] == 'r') prot |= PROT_READ;
+        if (perms[1] == 'w') prot |= PROT_WRITE;
+        if (perms[2] == 'x') prot |= PROT_EXEC;
+
+        *region = mapped_region { start, end, prot };
+        found = true;
+        break;
+    }
+
+    fclose(maps);
+    return found;
+#endif
+}
+
+/**
+ * Set the protection of the page at @a page.
+ *
+ * @param page The page address.
+ * @param size The page size.
+ * @param protection The new protection.
+ * @param writable If true, @a protection is ignored, and the page is made writable. On Darwin, this will
+ * create a private copy of the page if necessary.
+ */
+static bool set_protection (uintptr_t page, size_t size, protection_t protection, bool writable) {
+#ifdef __APPLE__
+    if (writable)
+        protection = VM_PROT_READ | VM_PROT_WRITE | VM_PROT_COPY;
+
+    return vm_protect(mach_task_self(), page, size, false, protection) == KERN_SUCCESS;
+#elif defined(__linux__)
+    if (writable)
+        protection = PROT_READ | PROT_WRITE;
+
+    return mprotect((void *) page, size, protection) == 0;
+#endif
+}
+
+BindSiteWriter::~BindSiteWriter () {
+    end();
+}
+
+/**
+ * Register a bind site to be made writable by this writer. All sites must be registered prior to calling begin().
+ *
+ * @param address The bind address.
+ */
+void BindSiteWriter::add (const void *address) {
+    static const uintptr_t page_mask = ~((uintptr_t) getpagesize() - 1);
+    _pages.push_back(((uintptr_t) address) & page_mask);
+}
+
+/**
+ * Make all pages containing a registered bind site writable. Each page's protection is modified at most once,
+ * and only if the page is not already writable.
+ *
+ * @return Returns false if any page could not be made writable, including a page that an earlier open writer
+ * failed to make writable. The writer is still opened, and end() must still be called (or the writer destroyed)
+ * to restore the protection of any modified pages; use writable() to determine which sites may be written.
+ */
+bool BindSiteWriter::begin () {
+    bool result = true;
+    size_t page_size = getpagesize();
+
+    std::sort(_pages.begin(), _pages.end());
+    _pages.erase(std::unique(_pages.begin(), _pages.end()), _pages.end());
+
+    std::lock_guard<std::mutex> guard(open_pages_lock);
+    _open = true;
+
+    /* Sites are sorted, and adjacent pages are likely to share a single region; the most recently queried
+     * region is reused where possible. */
+    mapped_region region = { 0, 0, 0 };
+    for (uintptr_t page : _pages) {
+        auto &state = (*open_pages)[page];
+        if (state.refs++ > 0) {
+            if (state.failed) {
+                _failed.push_back(page);
+                result = false;
+            }
+            continue;
+        }
+
+        if (page < region.start || page >= region.end) {
+            if (!query_region(page, &region)) {
+                PMLog("Failed to determine the protection of bind site page %p", (void *) page);
+                region = mapped_region { 0, 0, 0 };
+                state.changed = false;
+                state.failed = true;
+                _failed.push_back(page);
+                result = false;
+                continue;
+            }
+        }
+
+        state.protection = region.protection;
+        state.changed = (region.protection & PROTECTION_WRITE) == 0;
+        if (state.changed && !set_protection(page, page_size, 0, true)) {
+            PMLog("Failed to make bind site page %p writable", (void *) page);
+            state.changed = false;
+            state.failed = true;
+            _failed.push_back(page);
+            result = false;
+        }
+    }
+
+    return result;
+}
+
+/**
+ * Return true if the page containing @a address was made writable by begin(). This may only be called while the
+ * writer is open.
+ *
+ * @param address A registered bind address.
+ */
+bool BindSiteWriter::writable (const void *address) const {
+    static const uintptr_t page_mask = ~((uintptr_t) getpagesize() - 1);
+    return std::find(_failed.begin(), _failed.end(), ((uintptr_t) address) & page_mask) == _failed.end();
+}
+
+/**
+ * Restore the original protection of all pages made writable by begin(), once no other open writer includes
+ * the page. If the writer has not been opened, this is a no-op.
+ */
+void BindSiteWriter::end () {
+    if (!_open)
+        return;
+
+    size_t page_size = getpagesize();
+
+    std::lock_guard<std::mutex> guard(open_pages_lock);
+    for (uintptr_t page : _pages) {
+        auto state = open_pages->find(page);
+        if (--state->second.refs > 0)
+            continue;
+
+        if (state->second.changed && !set_protection(page, page_size, state->second.protection, false))
+            PMLog("Failed to restore the protection of bind site page %p", (void *) page);
+
+        open_pages->erase(state);
+    }
+
+    _failed.clear();
+    _open = false;
+}
+
+} /* namespace patchmaster */
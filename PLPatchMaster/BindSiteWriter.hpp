@@ -0,0 +1,85 @@
+/*
+ * Author: Landon Fuller <landon@landonf.org>
+ *
+ * Copyright (c) 2015 Landon Fuller <landon@landonf.org>.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+namespace patchmaster {
+
+/**
+ * Makes a batch of bind sites writable for the duration of a set of bind site writes.
+ *
+ * Bind sites may reside in read-only pages (e.g. __DATA_CONST, or an ELF RELRO segment). The writer groups
+ * all registered bind sites by page, and makes each page writable exactly once when the batch is opened; the
+ * original protections are restored when the batch is closed.
+ *
+ * Protection changes are reference counted across all writers; a page made writable by one batch will not be
+ * made read-only again until every batch that includes the page has been closed, allowing independent batches
+ * to be written concurrently from multiple threads.
+ *
+ * Instances of this class are not thread-safe.
+ */
+class BindSiteWriter {
+public:
+    BindSiteWriter () {}
+    ~BindSiteWriter ();
+
+    BindSiteWriter (const BindSiteWriter &) = delete;
+    BindSiteWriter &operator= (const BindSiteWriter &) = delete;
+
+    void add (const void *address);
+    bool begin ();
+    bool writable (const void *address) const;
+    void end ();
+
+    /**
+     * Publish @a value at the bind site @a address. The store is atomic, with release semantics; a thread
+     * that observes the new value through the bind site will also observe all writes that preceded it.
+     *
+     * @param address The bind address. The containing page must be writable.
+     * @param value The new value.
+     */
+    static inline void store (uintptr_t *address, uintptr_t value) {
+        __atomic_store_n(address, value, __ATOMIC_RELEASE);
+    }
+
+private:
+    /** The base addresses of all pages containing a registered bind site. */
+    std::vector<uintptr_t> _pages;
+
+    /** The base addresses of all registered pages that begin() could not make writable. */
+    std::vector<uintptr_t> _failed;
+
+    /** True if begin() has been called, and end() has not. */
+    bool _open = false;
+};
+
+} /* namespace patchmaster */
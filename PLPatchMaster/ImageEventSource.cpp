@@ -0,0 +1,365 @@
+/*
+ * Author: Landon Fuller <landon@landonf.org>
+ *
+ * Copyright (c) 2015 Landon Fuller <landon@landonf.org>.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "ImageEventSource.hpp"
+
+#include <sched.h>
+
+#include <new>
+#include <vector>
+
+#ifdef __APPLE__
+#include <mach-o/dyld.h>
+#elif defined(__linux__)
+#include <link.h>
+#include <limits.h>
+#include <unistd.h>
+#endif
+
+namespace patchmaster {
+
+/**
+ * Register @a listener to receive all future image events. A listener must not be registered more than once.
+ *
+ * If this is the first listener registered with the event source, the event source will be started; depending
+ * on the platform, events may be delivered for already-loaded images prior to this method returning.
+ *
+ * @param listener The listener to register. The listener must remain valid until removed.
+ */
+void ImageEventSource::add_listener (ImageEventListener *listener) {
+    /* Try to reuse a node vacated by a removed listener */
+    bool registered = false;
+    for (node *n = _head.load(std::memory_order_acquire); n != nullptr; n = n->next) {
+        ImageEventListener *expected = nullptr;
+        if (n->listener.compare_exchange_strong(expected, listener)) {
+            registered = true;
+            break;
+        }
+    }
+
+    /* Otherwise, push a new node. Nodes are never removed from the list, so there is no ABA hazard. */
+    if (!registered) {
+        node *n = new node();
+        n->listener.store(listener);
+        n->active.store(0);
+        n->next = _head.load(std::memory_order_relaxed);
+        while (!_head.compare_exchange_weak(n->next, n, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    if (!_started.exchange(true))
+        start();
+}
+
+/**
+ * Deregister @a listener. Once this method returns, no further events will be delivered to the listener, and no
+ * event dispatch to the listener remains in progress.
+ *
+ * This must not be called from within the listener's own event callback.
+ *
+ * @param listener The listener to deregister.
+ */
+void ImageEventSource::remove_listener (ImageEventListener *listener) {
+    for (node *n = _head.load(std::memory_order_acquire); n != nullptr; n = n->next) {
+        if (n->listener.load() != listener)
+            continue;
+
+        /* Clear the listener, and then wait for any in-progress dispatch to complete. Both operations are
+         * sequentially consistent, pairing with the increment-then-load performed by the dispatcher. */
+        n->listener.store(nullptr);
+        while (n->active.load() != 0)
+            sched_yield();
+
+        return;
+    }
+}
+
+/**
+ * Dispatch an image load event to all registered listeners.
+ *
+ * @param header The image's in-memory header address.
+ * @param slide The image's load address slide.
+ * @param path The image's path, or NULL if unknown.
+ */
+void ImageEventSource::dispatch_added (const void *header, intptr_t slide, const char *path) {
+    for (node *n = _head.load(std::memory_order_acquire); n != nullptr; n = n->next) {
+        n->active.fetch_add(1);
+        ImageEventListener *listener = n->listener.load();
+        if (listener != nullptr)
+            listener->image_added(header, slide, path);
+        n->active.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+/**
+ * Dispatch an image unload event to all registered listeners.
+ *
+ * @param header The image's in-memory header address.
+ * @param slide The image's load address slide.
+ * @param path The image's path, or NULL if unknown.
+ */
+void ImageEventSource::dispatch_removed (const void *header, intptr_t slide, const char *path) {
+    for (node *n = _head.load(std::memory_order_acquire); n != nullptr; n = n->next) {
+        n->active.fetch_add(1);
+        ImageEventListener *listener = n->listener.load();
+        if (listener != nullptr)
+            listener->image_removed(header, slide, path);
+        n->active.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+#ifdef __APPLE__
+
+/**
+ * An incrementally maintained mapping of dyld image headers to their paths and image indices.
+ *
+ * dyld only reports an image's header and slide to image callbacks; finding the path by scanning all loaded images on
+ * every load is O(n^2) across process launch. Instead, every image index not seen by the previous lookup is recorded,
+ * allowing lookups to be performed in amortized constant time.
+ */
+class DyldImageRegistry {
+public:
+    /** A registered image. */
+    struct entry {
+        /** The image's path, as owned by dyld. */
+        const char *path;
+
+        /** The image's dyld image index at the time it was registered. */
+        uint32_t index;
+    };
+
+    /**
+     * Look up the image with @a header, returning true and populating @a result if found.
+     */
+    bool lookup (const struct mach_header *header, entry *result) {
+        std::lock_guard<std::mutex> guard(_lock);
+
+        auto found = _images.find(header);
+        if (found == _images.end()) {
+            sync();
+            found = _images.find(header);
+            if (found == _images.end())
+                return false;
+        }
+
+        *result = found->second;
+        return true;
+    }
+
+    /**
+     * Remove the image with @a header. As dyld compacts its image list on removal, the remaining image
+     * indices will be re-synchronized on the next lookup miss.
+     */
+    void remove (const struct mach_header *header) {
+        std::lock_guard<std::mutex> guard(_lock);
+        _images.erase(header);
+        _scanned = 0;
+    }
+
+private:
+    /**
+     * Register all images with an index greater than or equal to _scanned. The caller must hold _lock.
+     */
+    void sync () {
+        uint32_t count = _dyld_image_count();
+        for (uint32_t i = _scanned; i < count; i++) {
+            auto header = _dyld_get_image_header(i);
+            const char *path = _dyld_get_image_name(i);
+            if (header == nullptr || path == nullptr)
+                continue;
+
+            _images[header] = entry { path, i };
+        }
+
+        _scanned = count;
+    }
+
+    /** Lock that must be held when accessing _images or _scanned. */
+    std::mutex _lock;
+
+    /** All registered images, keyed by header address. */
+    std::unordered_map<const struct mach_header *, entry> _images;
+
+    /** The number of dyld image indices that have been registered. */
+    uint32_t _scanned = 0;
+};
+
+/**
+ * A dyld image event source. Events are delivered synchronously from dyld's image callbacks.
+ */
+class DyldImageEventSource : public ImageEventSource {
+protected:
+    virtual void start () {
+        /* dyld will immediately call our add callback for all loaded images */
+        _dyld_register_func_for_add_image(image_added_cb);
+        _dyld_register_func_for_remove_image(image_removed_cb);
+    }
+
+private:
+    static DyldImageEventSource &instance ();
+
+    /* These *should* be dispatched after the Objective-C callbacks have been dispatched, but there's no gaurantee.
+     * It's possible, though unlikely, that this could break in a future release of Mac OS X. */
+    static void image_added_cb (const struct mach_header *mh, intptr_t vmaddr_slide) {
+        DyldImageRegistry::entry image;
+        if (!instance()._registry.lookup(mh, &image))
+            image.path = nullptr;
+
+        instance().dispatch_added(mh, vmaddr_slide, image.path);
+    }
+
+    static void image_removed_cb (const struct mach_header *mh, intptr_t vmaddr_slide) {
+        DyldImageRegistry::entry image;
+        if (!instance()._registry.lookup(mh, &image))
+            image.path = nullptr;
+
+        instance().dispatch_removed(mh, vmaddr_slide, image.path);
+        instance()._registry.remove(mh);
+    }
+
+    /** Maps image headers to their paths. */
+    DyldImageRegistry _registry;
+
+    friend class ImageEventSource;
+};
+
+/**
+ * Return the shared dyld event source.
+ */
+DyldImageEventSource &DyldImageEventSource::instance () {
+    /* Never destroyed; dyld may call our callbacks at any point up to process termination. */
+    static DyldImageEventSource *source = new DyldImageEventSource();
+    return *source;
+}
+
+/**
+ * Return the platform's shared image event source.
+ */
+ImageEventSource &ImageEventSource::shared () {
+    return DyldImageEventSource::instance();
+}
+
+#elif defined(__linux__)
+
+/**
+ * Return the platform's shared image event source.
+ */
+ImageEventSource &ImageEventSource::shared () {
+    /* Never destroyed; events may be polled at any point up to process termination. */
+    static PollingImageEventSource *source = new PollingImageEventSource();
+    return *source;
+}
+
+void PollingImageEventSource::start () {
+    poll();
+}
+
+/**
+ * Deliver events for all images loaded or unloaded since the previous poll.
+ */
+void PollingImageEventSource::poll () {
+    /** A single image reported by dl_iterate_phdr(). */
+    struct found_image {
+        const void *header;
+        intptr_t slide;
+        std::string path;
+    };
+
+    std::vector<found_image> found;
+    std::vector<found_image> added;
+    std::vector<found_image> removed;
+
+    /* Enumerate and diff the loaded images under our lock; a concurrent poll must not diff a stale enumeration
+     * against a newer image set, which would report a newly loaded image as removed. */
+    {
+        std::lock_guard<std::mutex> guard(_poll_lock);
+
+        dl_iterate_phdr([](struct dl_phdr_info *info, size_t size, void *ctx) -> int {
+            auto found = (std::vector<found_image> *) ctx;
+
+            /* The ELF header is mapped by the PT_LOAD segment at file offset 0 */
+            const void *header = nullptr;
+            for (ElfW(Half) i = 0; i < info->dlpi_phnum; i++) {
+                if (info->dlpi_phdr[i].p_type == PT_LOAD && info->dlpi_phdr[i].p_offset == 0) {
+                    header = (const void *) (info->dlpi_addr + info->dlpi_phdr[i].p_vaddr);
+                    break;
+                }
+            }
+
+            if (header == nullptr)
+                return 0;
+
+            /* The main executable is reported with an empty name */
+            std::string path = info->dlpi_name != nullptr ? info->dlpi_name : "";
+            if (path.empty()) {
+                char exe[PATH_MAX];
+                ssize_t len = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+                if (len > 0)
+                    path.assign(exe, len);
+            }
+
+            found->push_back(found_image { header, (intptr_t) info->dlpi_addr, path });
+            return 0;
+        }, &found);
+
+        /* Diff against the previously known image set */
+        _generation++;
+
+        for (auto &&img : found) {
+            auto known = _images.find(img.header);
+            if (known == _images.end()) {
+                _images.emplace(img.header, image { img.slide, img.path, _generation });
+                added.push_back(img);
+            } else {
+                known->second.generation = _generation;
+            }
+        }
+
+        for (auto it = _images.begin(); it != _images.end();) {
+            if (it->second.generation == _generation) {
+                it++;
+                continue;
+            }
+
+            removed.push_back(found_image { it->first, it->second.slide, it->second.path });
+            it = _images.erase(it);
+        }
+    }
+
+    /* Dispatch without holding our lock; listeners may themselves trigger a poll. */
+    for (auto &&img : removed)
+        dispatch_removed(img.header, img.slide, img.path.c_str());
+
+    for (auto &&img : added)
+        dispatch_added(img.header, img.slide, img.path.c_str());
+}
+
+#else
+#error Unsupported platform
+#endif
+
+} /* namespace patchmaster */
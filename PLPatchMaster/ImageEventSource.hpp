@@ -0,0 +1,160 @@
+/*
+ * Author: Landon Fuller <landon@landonf.org>
+ *
+ * Copyright (c) 2015 Landon Fuller <landon@landonf.org>.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace patchmaster {
+
+/**
+ * A listener that receives image load and unload events from an ImageEventSource.
+ *
+ * Events may be delivered on any thread, and may be delivered concurrently.
+ */
+class ImageEventListener {
+public:
+    virtual ~ImageEventListener () {}
+
+    /**
+     * Called when an image has been loaded.
+     *
+     * @param header The image's in-memory header address.
+     * @param slide The image's load address slide.
+     * @param path The image's path, or NULL if unknown. This pointer is only valid for the duration of the call.
+     */
+    virtual void image_added (const void *header, intptr_t slide, const char *path) = 0;
+
+    /**
+     * Called when an image is being unloaded.
+     *
+     * @param header The image's in-memory header address.
+     * @param slide The image's load address slide.
+     * @param path The image's path, or NULL if unknown. This pointer is only valid for the duration of the call.
+     */
+    virtual void image_removed (const void *header, intptr_t slide, const char *path) = 0;
+};
+
+/**
+ * A source of image load and unload events.
+ *
+ * Listeners are held in a lock-free, append-only list; event dispatch neither acquires a lock nor allocates
+ * memory. The platform's event source is started when its first listener is registered.
+ */
+class ImageEventSource {
+public:
+    static ImageEventSource &shared ();
+
+    virtual ~ImageEventSource () {}
+
+    void add_listener (ImageEventListener *listener);
+    void remove_listener (ImageEventListener *listener);
+
+protected:
+    ImageEventSource () : _head(nullptr), _started(false) {}
+
+    /** Begin delivering events. This will be called exactly once, upon registration of the first listener. */
+    virtual void start () = 0;
+
+    void dispatch_added (const void *header, intptr_t slide, const char *path);
+    void dispatch_removed (const void *header, intptr_t slide, const char *path);
+
+private:
+    /** A registered listener. Nodes are never deallocated. */
+    struct node {
+        /** The listener, or NULL if the listener has been removed and the node may be reused. */
+        std::atomic<ImageEventListener *> listener;
+
+        /** The number of events currently being dispatched to this node's listener. */
+        std::atomic<uint32_t> active;
+
+        /** The next node in the list, or NULL. */
+        node *next;
+    };
+
+    /** The head of the listener list. */
+    std::atomic<node *> _head;
+
+    /** True once start() has been called. */
+    std::atomic<bool> _started;
+};
+
+#ifdef __linux__
+
+/**
+ * A Linux ELF image event source, implemented by polling dl_iterate_phdr().
+ *
+ * The dynamic linker provides no image load notifications. The event source polls once when it is started
+ * (delivering events for all images loaded at that point); after that, nothing in this library polls on the
+ * caller's behalf. Code that loads or unloads images -- e.g. the caller of dlopen() or dlclose() -- is
+ * responsible for calling poll() afterwards, via the shared source:
+ *
+ * @code
+ * static_cast<PollingImageEventSource &>(ImageEventSource::shared()).poll();
+ * @endcode
+ *
+ * Until poll() is called, listeners will not observe the change. poll() may be called from any thread.
+ */
+class PollingImageEventSource : public ImageEventSource {
+public:
+    void poll ();
+
+protected:
+    virtual void start ();
+
+private:
+    /** A known image. */
+    struct image {
+        /** The image's load address slide. */
+        intptr_t slide;
+
+        /** The image's path. */
+        std::string path;
+
+        /** The poll generation in which the image was last seen. */
+        uint64_t generation;
+    };
+
+    /** Lock that must be held when enumerating the loaded images, or accessing _images or _generation. */
+    std::mutex _poll_lock;
+
+    /** All known images, keyed by header address. */
+    std::unordered_map<const void *, image> _images;
+
+    /** The current poll generation. */
+    uint64_t _generation = 0;
+};
+
+#endif /* __linux__ */
+
+} /* namespace patchmaster */
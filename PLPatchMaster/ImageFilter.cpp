@@ -0,0 +1,222 @@
+/*
+ * Author: Landon Fuller <landon@landonf.org>
+ *
+ * Copyright (c) 2015 Landon Fuller <landon@landonf.org>.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "ImageFilter.hpp"
+
+#include <fnmatch.h>
+
+namespace patchmaster {
+
+/**
+ * Construct a new, empty image filter. An empty filter includes all images.
+ */
+ImageFilter::ImageFilter () : _nodes(1) {}
+
+/**
+ * Insert @a prefix into the trie, returning the index of its terminal node.
+ */
+size_t ImageFilter::insert (const std::string &prefix) {
+    size_t idx = 0;
+    for (char c : prefix) {
+        auto child = _nodes[idx].children.find(c);
+        if (child != _nodes[idx].children.end()) {
+            idx = child->second;
+            continue;
+        }
+
+        /* Note that we must not hold a reference to _nodes[idx] across the push_back() */
+        _nodes.push_back(node());
+        _nodes[idx].children.emplace(c, _nodes.size() - 1);
+        idx = _nodes.size() - 1;
+    }
+
+    return idx;
+}
+
+/**
+ * Add a rule matching only the image at @a path.
+ *
+ * @param action The action to be applied to the matching image.
+ * @param path The image path to match.
+ */
+void ImageFilter::add_path (action_t action, const std::string &path) {
+    auto &n = _nodes[insert(path)];
+
+    /* Exclusion takes precedence over an identical include rule */
+    if (n.path_action != ACTION_EXCLUDE)
+        n.path_action = action;
+
+    _rule_count++;
+    if (action == ACTION_INCLUDE)
+        _has_includes = true;
+
+    invalidate();
+}
+
+/**
+ * Add a rule matching all image paths that begin with @a prefix.
+ *
+ * @param action The action to be applied to matching images.
+ * @param prefix The path prefix to match.
+ */
+void ImageFilter::add_prefix (action_t action, const std::string &prefix) {
+    auto &n = _nodes[insert(prefix)];
+
+    /* Exclusion takes precedence over an identical include rule */
+    if (n.prefix_action != ACTION_EXCLUDE)
+        n.prefix_action = action;
+
+    _rule_count++;
+    if (action == ACTION_INCLUDE)
+        _has_includes = true;
+
+    invalidate();
+}
+
+/**
+ * Add a rule matching all image paths that match the fnmatch(3) glob @a pattern. The pattern is matched without
+ * FNM_PATHNAME; a '*' wildcard will match across path separators.
+ *
+ * @param action The action to be applied to matching images.
+ * @param pattern The glob pattern to match.
+ */
+void ImageFilter::add_pattern (action_t action, const std::string &pattern) {
+    /* Index the pattern by its literal prefix */
+    auto literal_len = pattern.find_first_of("*?[\\");
+    if (literal_len == std::string::npos) {
+        /* No wildcards; the pattern will only match the exact path, and is indexed by the full path. */
+        literal_len = pattern.size();
+    }
+
+    auto &n = _nodes[insert(pattern.substr(0, literal_len))];
+    n.patterns.push_back(pattern_rule { pattern, action });
+
+    _rule_count++;
+    if (action == ACTION_INCLUDE)
+        _has_includes = true;
+
+    invalidate();
+}
+
+/**
+ * Set a predicate that must also return true for an image to be included. The predicate is only evaluated
+ * for images included by the filter's rules. Its result is cached by image path, but concurrent classifications
+ * of the same path may each evaluate the predicate (see includes()); it must be thread-safe, and must return
+ * the same result for a given path.
+ *
+ * @param predicate The predicate, or an empty function to remove any existing predicate.
+ */
+void ImageFilter::set_predicate (const predicate_t &predicate) {
+    _predicate = predicate;
+    invalidate();
+}
+
+/**
+ * Discard all cached classifications.
+ */
+void ImageFilter::invalidate () {
+    std::lock_guard<std::mutex> guard(_cache_lock);
+    _cache.clear();
+}
+
+/**
+ * Classify @a path against the filter's rules, without consulting the cache.
+ */
+bool ImageFilter::classify (const char *path) const {
+    action_t result = ACTION_NONE;
+
+    /* Walk the trie; deeper matches are more specific, and override any previous match. */
+    size_t idx = 0;
+    for (const char *p = path;; p++) {
+        const node &n = _nodes[idx];
+        action_t matched = n.prefix_action;
+
+        for (auto &&rule : n.patterns) {
+            if (matched == ACTION_EXCLUDE)
+                break;
+
+            if (fnmatch(rule.pattern.c_str(), path, 0) == 0)
+                matched = rule.action;
+        }
+
+        if (matched != ACTION_NONE)
+            result = matched;
+
+        if (*p == '\0') {
+            /* An exact path match is the most specific possible match */
+            if (n.path_action != ACTION_NONE)
+                result = n.path_action;
+            break;
+        }
+
+        auto child = n.children.find(*p);
+        if (child == n.children.end())
+            break;
+
+        idx = child->second;
+    }
+
+    bool included;
+    if (result == ACTION_NONE)
+        included = !_has_includes;
+    else
+        included = (result == ACTION_INCLUDE);
+
+    if (included && _predicate)
+        return _predicate(path);
+
+    return included;
+}
+
+/**
+ * Return true if the image at @a path is included by this filter.
+ *
+ * The image is classified without holding the cache lock; classification may be expensive, and the user
+ * predicate may itself trigger an image load (and thus a reentrant call to this method). Concurrent callers
+ * may redundantly classify the same path, in which case the first result to be cached is retained.
+ *
+ * @param path The image path.
+ */
+bool ImageFilter::includes (const char *path) const {
+    if (empty())
+        return true;
+
+    {
+        std::lock_guard<std::mutex> guard(_cache_lock);
+        auto cached = _cache.find(path);
+        if (cached != _cache.end())
+            return cached->second;
+    }
+
+    bool result = classify(path);
+
+    std::lock_guard<std::mutex> guard(_cache_lock);
+    return _cache.emplace(path, result).first->second;
+}
+
+} /* namespace patchmaster */
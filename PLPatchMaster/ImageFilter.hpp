@@ -0,0 +1,136 @@
+/*
+ * Author: Landon Fuller <landon@landonf.org>
+ *
+ * Copyright (c) 2015 Landon Fuller <landon@landonf.org>.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace patchmaster {
+
+/**
+ * A set of include/exclude rules used to select images by path.
+ *
+ * Rules are matched against an image's path by exact path, by literal prefix, or by fnmatch(3) glob pattern. All
+ * rules are compiled into a prefix trie keyed by their literal prefix (for glob patterns, the characters preceding the
+ * first wildcard), allowing an image to be classified in a single walk of its path.
+ *
+ * When multiple rules match a path, the rule with the longest literal prefix takes precedence; if an include and an
+ * exclude rule are equally specific, the exclude rule wins. If no rule matches, the image is included only if the
+ * filter defines no include rules.
+ *
+ * An optional predicate may be supplied to further restrict the included images; it is only consulted for images
+ * that have been included by the filter's rules.
+ *
+ * Classification results are cached by path. Adding a rule discards the cache; once all rules have been added,
+ * the filter may be safely shared across threads.
+ */
+class ImageFilter {
+public:
+    /** Rule actions. */
+    enum action_t : uint8_t {
+        /** No rule. */
+        ACTION_NONE = 0,
+
+        /** Include matching images. */
+        ACTION_INCLUDE = 1,
+
+        /** Exclude matching images. */
+        ACTION_EXCLUDE = 2
+    };
+
+    ImageFilter ();
+
+    /** A predicate used to further restrict the images included by a filter. */
+    typedef std::function<bool(const char *path)> predicate_t;
+
+    void add_path (action_t action, const std::string &path);
+    void add_prefix (action_t action, const std::string &prefix);
+    void add_pattern (action_t action, const std::string &pattern);
+    void set_predicate (const predicate_t &predicate);
+
+    bool includes (const char *path) const;
+
+    /** Return true if no rules have been added to this filter. */
+    bool empty () const { return _rule_count == 0 && !_predicate; }
+
+private:
+    /** A glob pattern rule. */
+    struct pattern_rule {
+        /** The full fnmatch(3) pattern. */
+        std::string pattern;
+
+        /** The rule's action. */
+        action_t action;
+    };
+
+    /** A single trie node. */
+    struct node {
+        /** Child nodes, keyed by the next path character. Values are indices into _nodes. */
+        std::map<char, size_t> children;
+
+        /** The action for an exact path rule terminating at this node, if any. */
+        action_t path_action = ACTION_NONE;
+
+        /** The action for a prefix rule terminating at this node, if any. */
+        action_t prefix_action = ACTION_NONE;
+
+        /** Glob pattern rules whose literal prefix terminates at this node. */
+        std::vector<pattern_rule> patterns;
+    };
+
+    size_t insert (const std::string &prefix);
+    void invalidate ();
+    bool classify (const char *path) const;
+
+    /** All trie nodes; the root node is always at index 0. */
+    std::vector<node> _nodes;
+
+    /** Total number of rules. */
+    size_t _rule_count = 0;
+
+    /** True if any include rules have been registered. */
+    bool _has_includes = false;
+
+    /** The optional predicate applied to all included images. */
+    predicate_t _predicate;
+
+    /** Lock that must be held when accessing _cache. */
+    mutable std::mutex _cache_lock;
+
+    /** Previously computed classifications, keyed by image path. */
+    mutable std::unordered_map<std::string, bool> _cache;
+};
+
+} /* namespace patchmaster */
@@ -0,0 +1,232 @@
+/*
+ * Author: Landon Fuller <landon@landonf.org>
+ *
+ * Copyright (c) 2015 Landon Fuller <landon@landonf.org>.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "Interposer.hpp"
+#include "TrampolineTable.hpp"
+#include "PMLog.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+
+#include <new>
+#include <vector>
+
+#if defined(__x86_64__)
+extern "C" {
+#include "interpose_x86_64.h"
+
+/* Shared entry and return handlers; see interpose_x86_64.S */
+extern void pm_interpose_entry (void);
+extern void pm_interpose_return (void);
+}
+#define INTERPOSE_TABLE_SUPPORTED 1
+#else
+#define INTERPOSE_TABLE_SUPPORTED 0
+#endif
+
+namespace patchmaster {
+
+namespace {
+
+/** The interposition state referenced by a single trampoline's config entry. */
+struct record {
+    /** The pre-hook, or NULL. */
+    PLPatchInterposePreHook pre;
+
+    /** The post-hook, or NULL. */
+    PLPatchInterposePostHook post;
+
+    /** The context pointer passed to all hooks. */
+    void *context;
+
+    /** The original function. */
+    void *function;
+};
+
+/** A single in-progress interposed call. */
+struct frame {
+    /** The interposer record. */
+    const record *rec;
+
+    /** The caller's original return address. */
+    void *return_address;
+};
+
+/** A per-thread stack of in-progress interposed calls. */
+typedef std::vector<frame> shadow_stack;
+
+/**
+ * Free an exiting thread's shadow stack.
+ */
+void shadow_stack_destructor (void *value) {
+    delete (shadow_stack *) value;
+}
+
+/**
+ * Return the calling thread's shadow stack, allocating it if necessary.
+ */
+shadow_stack &thread_shadow_stack () {
+    static pthread_key_t key;
+    static bool initialized = [] {
+        if (pthread_key_create(&key, shadow_stack_destructor) != 0)
+            PMFatal("Failed to allocate an interposer thread-local key");
+        return true;
+    }();
+    (void) initialized;
+
+    auto stack = (shadow_stack *) pthread_getspecific(key);
+    if (stack != nullptr)
+        return *stack;
+
+    stack = new (std::nothrow) shadow_stack();
+    if (stack == nullptr)
+        PMFatal("Failed to allocate an interposer shadow stack");
+
+    pthread_setspecific(key, stack);
+    return *stack;
+}
+
+#if INTERPOSE_TABLE_SUPPORTED
+/**
+ * Return the shared interposer trampoline table.
+ */
+TrampolineTable &interpose_table () {
+    static TrampolineTable *table = new TrampolineTable(&pl_interpose_table_page_config);
+    return *table;
+}
+#endif /* INTERPOSE_TABLE_SUPPORTED */
+
+} /* anonymous namespace */
+
+/**
+ * @internal
+ *
+ * Called by the interposer entry handler with the saved argument registers. Calls the pre-hook, records the
+ * caller's return address on the calling thread's shadow stack, and replaces it with the address of the
+ * interposer return handler.
+ *
+ * @param config The trampoline's config entry.
+ * @param arguments The saved argument registers.
+ * @param return_address The stack slot holding the caller's return address.
+ *
+ * @return Returns the original function to be called.
+ */
+extern "C" __attribute__((visibility("hidden"))) void *pm_interpose_enter (void **config, PLPatchInterposeArguments *arguments, void **return_address) {
+    auto rec = (const record *) config[0];
+
+    if (rec->pre != nullptr)
+        rec->pre(rec->context, rec->function, arguments);
+
+#if INTERPOSE_TABLE_SUPPORTED
+    shadow_stack &stack = thread_shadow_stack();
+    try {
+        stack.push_back({ rec, *return_address });
+    } catch (std::bad_alloc &) {
+        PMFatal("Failed to grow the interposer shadow stack");
+    }
+
+    *return_address = (void *) &pm_interpose_return;
+#endif
+
+    return rec->function;
+}
+
+/**
+ * @internal
+ *
+ * Called by the interposer return handler with the saved return registers. Pops the calling thread's shadow
+ * stack, and calls the post-hook.
+ *
+ * @param results The saved return registers.
+ *
+ * @return Returns the caller's original return address.
+ */
+extern "C" __attribute__((visibility("hidden"))) void *pm_interpose_exit (PLPatchInterposeResults *results) {
+    shadow_stack &stack = thread_shadow_stack();
+    if (stack.empty())
+        PMFatal("Interposer return with an empty shadow stack");
+
+    frame f = stack.back();
+    stack.pop_back();
+
+    if (f.rec->post != nullptr)
+        f.rec->post(f.rec->context, f.rec->function, results);
+
+    return f.return_address;
+}
+
+/**
+ * Construct a new interposer. Entry points returned by interpose() retain a copy of the interposer's hooks and
+ * context, and remain valid after the interposer itself has been destroyed.
+ *
+ * @param pre The hook to be called prior to the original function, or NULL.
+ * @param post The hook to be called after the original function returns, or NULL.
+ * @param context A context pointer to be passed to @a pre and @a post.
+ */
+Interposer::Interposer (PLPatchInterposePreHook pre, PLPatchInterposePostHook post, void *context) : _pre(pre), _post(post), _context(context) {}
+
+/**
+ * Return an entry point that may be called in place of @a function, with any signature supported by the target
+ * calling convention. Each call is routed through this interposer's hooks.
+ *
+ * Interposer trampolines are never deallocated.
+ *
+ * @param function The function to be interposed.
+ *
+ * @return Returns the interposing entry point, or NULL if interposition is not supported on the current
+ * architecture, or a trampoline could not be allocated.
+ */
+void *Interposer::interpose (void *function) {
+#if INTERPOSE_TABLE_SUPPORTED
+    auto rec = new (std::nothrow) record { _pre, _post, _context, function };
+    if (rec == nullptr)
+        return nullptr;
+
+    TrampolineTable &table = interpose_table();
+    void *trampoline = table.alloc();
+    if (trampoline == nullptr) {
+        delete rec;
+        return nullptr;
+    }
+
+    void **config = table.config_ptr(trampoline);
+    config[0] = rec;
+    config[1] = (void *) &pm_interpose_entry;
+
+    return trampoline;
+#else
+    return nullptr;
+#endif
+}
+
+bool Interposer::supported () {
+    return INTERPOSE_TABLE_SUPPORTED;
+}
+
+} /* namespace patchmaster */
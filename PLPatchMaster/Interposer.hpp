@@ -0,0 +1,75 @@
+/*
+ * Author: Landon Fuller <landon@landonf.org>
+ *
+ * Copyright (c) 2015 Landon Fuller <landon@landonf.org>.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <stddef.h>
+
+#include "PLPatchInterposer.h"
+
+namespace patchmaster {
+
+/**
+ * Generic, signature-independent function interposition.
+ *
+ * An interposer trampoline saves all argument registers, calls a pre-hook, calls the original function with the
+ * (possibly modified) argument registers and the caller's stack arguments intact, calls a post-hook with the
+ * return registers, and then returns to the caller.
+ *
+ * To regain control when the original function returns, the caller's return address is saved on a per-thread
+ * shadow stack and replaced with the address of the interposer's return handler. As a result, interposed functions
+ * must not be exited by unwinding (eg, via a C++ exception or longjmp()).
+ *
+ * Interposition is currently supported for the SysV x86-64 calling convention; on other architectures, interpose()
+ * will always fail.
+ */
+class Interposer {
+public:
+    Interposer (PLPatchInterposePreHook pre, PLPatchInterposePostHook post, void *context);
+
+    Interposer (const Interposer &) = delete;
+    Interposer &operator= (const Interposer &) = delete;
+
+    void *interpose (void *function);
+
+    /** Return true if interposition is supported on the current architecture. */
+    static bool supported ();
+
+private:
+    /** The pre-hook, or NULL. */
+    PLPatchInterposePreHook _pre;
+
+    /** The post-hook, or NULL. */
+    PLPatchInterposePostHook _post;
+
+    /** The context pointer passed to all hooks. */
+    void *_context;
+};
+
+} /* namespace patchmaster */
@@ -48,6 +48,9 @@ typedef enum {
     
     /** Block returns its aggregate value in memory (ie, the block has a structure return type). */
     BLOCK_USE_STRET =         (1 << 29),
+    
+    /** Block descriptor includes an Objective-C type encoding of the block's signature. */
+    BLOCK_HAS_SIGNATURE =     (1 << 30),
 } block_flags_t;
 
 
@@ -0,0 +1,116 @@
+/*
+ * Author: Landon Fuller <landonf@plausiblelabs.com>
+ *
+ * Copyright (c) 2013-2015 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#import "PLPatchCompletionPrivate.h"
+
+/**
+ * A handle to an asynchronous patch operation, as returned by the asynchronous PLPatchMaster APIs.
+ *
+ * The handle may be used to wait for (or be notified of) completion of the operation. All methods are thread-safe.
+ */
+@implementation PLPatchCompletion
+
+/**
+ * @internal
+ *
+ * Enqueue @a operation on @a queue, returning a handle that will complete once the operation has been executed.
+ *
+ * @param queue The queue on which @a operation will be executed.
+ * @param operation The operation to be executed; its return value is reported via -succeeded.
+ */
+- (instancetype) initWithQueue: (dispatch_queue_t) queue operation: (BOOL (^)(void)) operation {
+    if ((self = [super init]) == nil)
+        return nil;
+
+    _group = dispatch_group_create();
+
+    /* The block retains the receiver until the operation has completed */
+    dispatch_group_async(_group, queue, ^{
+        @autoreleasepool {
+            _succeeded = operation();
+        }
+    });
+
+    return self;
+}
+
+- (void) dealloc {
+    dispatch_release(_group);
+    [super dealloc];
+}
+
+/**
+ * Block the calling thread until the operation has completed.
+ *
+ * This must not be called from within a patch or image filter callback.
+ */
+- (void) wait {
+    dispatch_group_wait(_group, DISPATCH_TIME_FOREVER);
+}
+
+/**
+ * Block the calling thread until the operation has completed, or @a timeout has elapsed.
+ *
+ * @param timeout The maximum number of seconds to wait.
+ *
+ * @return Returns YES if the operation completed, or NO if the timeout elapsed first.
+ */
+- (BOOL) waitWithTimeout: (NSTimeInterval) timeout {
+    dispatch_time_t deadline = dispatch_time(DISPATCH_TIME_NOW, (int64_t) (timeout * NSEC_PER_SEC));
+    return dispatch_group_wait(_group, deadline) == 0;
+}
+
+/**
+ * Schedule @a block to be submitted to @a queue once the operation has completed. If the operation has
+ * already completed, the block is submitted immediately.
+ *
+ * @param queue The queue to which @a block will be submitted.
+ * @param block The block to be executed.
+ */
+- (void) notifyOnQueue: (dispatch_queue_t) queue block: (dispatch_block_t) block {
+    dispatch_group_notify(_group, queue, block);
+}
+
+/**
+ * Return YES if the operation has completed.
+ */
+- (BOOL) isComplete {
+    return dispatch_group_wait(_group, DISPATCH_TIME_NOW) == 0;
+}
+
+/**
+ * Return YES if the operation completed successfully. If the operation has not yet completed, this will block
+ * until it does.
+ */
+- (BOOL) succeeded {
+    [self wait];
+    return _succeeded;
+}
+
+@end
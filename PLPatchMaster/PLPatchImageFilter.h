@@ -0,0 +1,77 @@
+/*
+ * Author: Landon Fuller <landonf@plausiblelabs.com>
+ *
+ * Copyright (c) 2013-2015 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import <Foundation/Foundation.h>
+
+/**
+ * A predicate used to restrict the images included by a PLPatchImageFilter.
+ *
+ * @param imagePath The path of the image.
+ *
+ * @return YES if the image should be included, NO otherwise.
+ */
+typedef BOOL (^PLPatchImagePredicate)(NSString *imagePath);
+
+@interface PLPatchImageFilter : NSObject {
+@private
+    /** Path prefixes of images to be included. */
+    NSMutableArray *_includePrefixes;
+
+    /** Path prefixes of images to be excluded. */
+    NSMutableArray *_excludePrefixes;
+
+    /** fnmatch(3) patterns matching images to be included. */
+    NSMutableArray *_includePatterns;
+
+    /** fnmatch(3) patterns matching images to be excluded. */
+    NSMutableArray *_excludePatterns;
+
+    /** Paths of individual images to be included. */
+    NSMutableArray *_includePaths;
+
+    /** Paths of individual images to be excluded. */
+    NSMutableArray *_excludePaths;
+
+    /** The predicate applied to all included images, or nil. */
+    PLPatchImagePredicate _predicate;
+}
+
++ (instancetype) filter;
+
+- (void) includeImagesWithPathPrefix: (NSString *) prefix;
+- (void) excludeImagesWithPathPrefix: (NSString *) prefix;
+
+- (void) includeImagesMatchingPattern: (NSString *) pattern;
+- (void) excludeImagesMatchingPattern: (NSString *) pattern;
+
+- (void) includeImageAtPath: (NSString *) path;
+- (void) excludeImageAtPath: (NSString *) path;
+
+- (void) setPredicate: (PLPatchImagePredicate) predicate;
+
+@end
@@ -0,0 +1,198 @@
+/*
+ * Author: Landon Fuller <landonf@plausiblelabs.com>
+ *
+ * Copyright (c) 2013-2015 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "PLPatchImageFilterPrivate.h"
+
+using namespace patchmaster;
+
+/**
+ * A set of include and exclude rules used to restrict symbol rebinding to images matching an exact path, a path
+ * prefix, or an fnmatch(3) glob pattern.
+ *
+ * When multiple rules match an image, the most specific rule (the rule with the longest literal path prefix)
+ * takes precedence; if equally specific include and exclude rules match, the image is excluded. An image that
+ * matches no rule is included only if the filter defines no include rules.
+ *
+ * The filter's rules are captured at the time the filter is passed to PLPatchMaster; later modifications
+ * will not affect previously registered rebindings. This class is not thread-safe.
+ */
+@implementation PLPatchImageFilter
+
+/**
+ * Return a new, empty filter. An empty filter includes all images.
+ */
++ (instancetype) filter {
+    return [[[self alloc] init] autorelease];
+}
+
+- (instancetype) init {
+    if ((self = [super init]) == nil)
+        return nil;
+
+    /* Default state */
+    _includePrefixes = [[NSMutableArray array] retain];
+    _excludePrefixes = [[NSMutableArray array] retain];
+    _includePatterns = [[NSMutableArray array] retain];
+    _excludePatterns = [[NSMutableArray array] retain];
+    _includePaths = [[NSMutableArray array] retain];
+    _excludePaths = [[NSMutableArray array] retain];
+
+    return self;
+}
+
+- (void) dealloc {
+    [_includePrefixes release];
+    [_excludePrefixes release];
+    [_includePatterns release];
+    [_excludePatterns release];
+    [_includePaths release];
+    [_excludePaths release];
+    [_predicate release];
+    [super dealloc];
+}
+
+/**
+ * Include all images whose path begins with @a prefix (e.g. '/Applications/Example.app/').
+ *
+ * @param prefix The image path prefix.
+ */
+- (void) includeImagesWithPathPrefix: (NSString *) prefix {
+    [_includePrefixes addObject: [[prefix copy] autorelease]];
+}
+
+/**
+ * Exclude all images whose path begins with @a prefix (e.g. '/System/Library/').
+ *
+ * @param prefix The image path prefix.
+ */
+- (void) excludeImagesWithPathPrefix: (NSString *) prefix {
+    [_excludePrefixes addObject: [[prefix copy] autorelease]];
+}
+
+/**
+ * Include all images whose path matches the fnmatch(3) glob @a pattern (e.g. '*.framework/Versions/A/Example').
+ * The '*' wildcard will match across path separators.
+ *
+ * @param pattern The glob pattern.
+ */
+- (void) includeImagesMatchingPattern: (NSString *) pattern {
+    [_includePatterns addObject: [[pattern copy] autorelease]];
+}
+
+/**
+ * Exclude all images whose path matches the fnmatch(3) glob @a pattern (e.g. '/usr/lib/libobjc*').
+ * The '*' wildcard will match across path separators.
+ *
+ * @param pattern The glob pattern.
+ */
+- (void) excludeImagesMatchingPattern: (NSString *) pattern {
+    [_excludePatterns addObject: [[pattern copy] autorelease]];
+}
+
+/**
+ * Include the single image at @a path. The path must match the image's path as reported by dyld.
+ *
+ * @param path The image path.
+ */
+- (void) includeImageAtPath: (NSString *) path {
+    [_includePaths addObject: [[path copy] autorelease]];
+}
+
+/**
+ * Exclude the single image at @a path. The path must match the image's path as reported by dyld.
+ *
+ * @param path The image path.
+ */
+- (void) excludeImageAtPath: (NSString *) path {
+    [_excludePaths addObject: [[path copy] autorelease]];
+}
+
+/**
+ * Set a predicate that must also return YES for an image to be included. The predicate is only consulted for
+ * images included by the filter's rules. Its result is cached by image path, but the predicate may be evaluated
+ * more than once -- including concurrently -- for the same path; it must be thread-safe, and must return the same
+ * result for any given image path.
+ *
+ * The predicate may be called from any thread, with PLPatchMaster's internal locks held; it must not call
+ * back into PLPatchMaster.
+ *
+ * @param predicate The predicate, or nil to remove any existing predicate.
+ */
+- (void) setPredicate: (PLPatchImagePredicate) predicate {
+    if (predicate == _predicate)
+        return;
+
+    [_predicate release];
+    _predicate = [predicate copy];
+}
+
+/**
+ * @internal
+ *
+ * Compile the filter's current rules. The returned filter is independent of any later changes to the receiver,
+ * and caches the classification of each image path it is asked to evaluate.
+ */
+- (std::shared_ptr<const ImageFilter>) compiledFilter {
+    auto filter = std::make_shared<ImageFilter>();
+
+    for (NSString *prefix in _includePrefixes)
+        filter->add_prefix(ImageFilter::ACTION_INCLUDE, prefix.UTF8String);
+
+    for (NSString *prefix in _excludePrefixes)
+        filter->add_prefix(ImageFilter::ACTION_EXCLUDE, prefix.UTF8String);
+
+    for (NSString *pattern in _includePatterns)
+        filter->add_pattern(ImageFilter::ACTION_INCLUDE, pattern.UTF8String);
+
+    for (NSString *pattern in _excludePatterns)
+        filter->add_pattern(ImageFilter::ACTION_EXCLUDE, pattern.UTF8String);
+
+    for (NSString *path in _includePaths)
+        filter->add_path(ImageFilter::ACTION_INCLUDE, path.UTF8String);
+
+    for (NSString *path in _excludePaths)
+        filter->add_path(ImageFilter::ACTION_EXCLUDE, path.UTF8String);
+
+    if (_predicate != nil) {
+        /* The compiled filter may outlive the receiver; it holds its own reference to the predicate */
+        PLPatchImagePredicate predicate = [_predicate copy];
+        auto retained = std::shared_ptr<void>((void *) predicate, [](void *block) {
+            [(id) block release];
+        });
+
+        filter->set_predicate([predicate, retained](const char *path) {
+            @autoreleasepool {
+                return (bool) predicate([NSString stringWithUTF8String: path]);
+            }
+        });
+    }
+
+    return filter;
+}
+
+@end
@@ -0,0 +1,96 @@
+/*
+ * Author: Landon Fuller <landonf@plausiblelabs.com>
+ *
+ * Copyright (c) 2013-2015 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * The argument registers of an interposed call, as saved on entry to a generic interposer trampoline. Changes made
+ * by a pre-hook are applied before the original function is called.
+ *
+ * The layout matches the SysV x86-64 calling convention.
+ */
+typedef struct PLPatchInterposeArguments {
+    /** The integer argument registers: %rdi, %rsi, %rdx, %rcx, %r8, %r9. */
+    uintptr_t gpr[6];
+
+    /** The value of %rax; for variadic calls, the number of vector registers used. */
+    uintptr_t rax;
+
+    /** Unused; maintains the alignment of the vector registers. */
+    uintptr_t reserved;
+
+    /** The vector argument registers: %xmm0-%xmm7. */
+    uint8_t vector[8][16];
+
+    /** A pointer to the first stack-passed argument, if any. */
+    void *stack;
+} PLPatchInterposeArguments;
+
+/**
+ * The return registers of an interposed call, as saved on return from the original function. Changes made by a
+ * post-hook are applied before returning to the caller.
+ *
+ * The layout matches the SysV x86-64 calling convention. Values returned on the x87 stack (eg, long double) are
+ * not captured, and may not be returned through an interposer.
+ */
+typedef struct PLPatchInterposeResults {
+    /** The integer return registers: %rax, %rdx. */
+    uintptr_t gpr[2];
+
+    /** The vector return registers: %xmm0, %xmm1. */
+    uint8_t vector[2][16];
+} PLPatchInterposeResults;
+
+/**
+ * A generic interposer pre-hook, called before the original function.
+ *
+ * @param context The context pointer supplied when the interposer was created.
+ * @param function The original function.
+ * @param arguments The saved argument registers.
+ */
+typedef void (*PLPatchInterposePreHook)(void *context, void *function, PLPatchInterposeArguments *arguments);
+
+/**
+ * A generic interposer post-hook, called after the original function has returned.
+ *
+ * @param context The context pointer supplied when the interposer was created.
+ * @param function The original function.
+ * @param results The saved return registers.
+ */
+typedef void (*PLPatchInterposePostHook)(void *context, void *function, PLPatchInterposeResults *results);
+
+#ifdef __cplusplus
+}
+#endif
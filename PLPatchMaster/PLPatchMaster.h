@@ -28,6 +28,10 @@
 
 #import <Foundation/Foundation.h>
 #import "NSObject+PLPatchMaster.h"
+#import "PLPatchSet.h"
+#import "PLPatchImageFilter.h"
+#import "PLPatchCompletion.h"
+#import "PLPatchInterposer.h"
 
 /**
  * IMP patch state, as passed to a replacement block.
@@ -59,6 +63,66 @@ typedef struct PLPatchIMP {
  */
 #define PLPatchGetSelf(patch) ((__bridge id) patch->self)
 
+/**
+ * Register ABI IMP patch state, as passed to a replacement block.
+ *
+ * A replacement block whose first parameter is a (const) pointer to PLPatchIMPSlot is dispatched without
+ * constructing a PLPatchIMP on the stack; the slot references the patch's configuration directly, and the original
+ * message target is passed as the block's second parameter:
+ *
+ * @code
+ * ^(const PLPatchIMPSlot *slot, id self, NSUInteger value) {
+ *     return PLPatchIMPSlotForward(slot, self, NSUInteger (*)(id, SEL, NSUInteger), value) + 1;
+ * }
+ * @endcode
+ *
+ * Register ABI blocks are supported on x86-64 (up to three integer or pointer method arguments) and ARM64 (up to
+ * five), and may not declare aggregate arguments. On x86-64, they may not return structures in memory.
+ */
+typedef struct PLPatchIMPSlot {
+    /** The original IMP (eg, the IMP prior to patching) */
+    IMP origIMP;
+
+    /** The original SEL. */
+    SEL selector;
+} PLPatchIMPSlot;
+
+/**
+ * Forward a message received by a PLPatchMaster register ABI patch block.
+ *
+ * @param slot The PLPatchIMPSlot patch argument.
+ * @param self The original message target.
+ * @param func_type The function type to which the IMP should be cast.
+ * @param ... All method arguments (Do not include self or _cmd).
+ */
+#define PLPatchIMPSlotForward(slot, self, func_type, ...) ((func_type)slot->origIMP)(self, slot->selector, ##__VA_ARGS__)
+
+/**
+ * An observe-only patch callback.
+ *
+ * @param self The message receiver.
+ * @param _cmd The message selector.
+ * @param context The context pointer supplied when the observer was registered.
+ */
+typedef void (*PLPatchObserver)(id self, SEL _cmd, void *context);
+
+/**
+ * Symbol patch state, as passed to a symbol replacement block.
+ */
+typedef struct PLPatchFunction {
+    /** The original function (eg, the function prior to patching). */
+    void *origFunction;
+} PLPatchFunction;
+
+/**
+ * Forward a call received by a PLPatchMaster symbol replacement block.
+ *
+ * @param patch The PLPatchFunction patch argument.
+ * @param func_type The function type to which the original function should be cast.
+ * @param ... All function arguments.
+ */
+#define PLPatchFunctionForward(patch, func_type, ...) ((func_type)patch->origFunction)(__VA_ARGS__)
+
 @class PLPatchMasterImpl;
 
 extern NSString *kPLPatchImageFoundation;
@@ -74,10 +138,40 @@ extern NSString *kPLPatchImageLibSystem;
 - (BOOL) patchClass: (Class) cls selector: (SEL) selector replacementBlock: (id) replacementBlock;
 - (BOOL) patchInstancesWithClass: (Class) cls selector: (SEL) selector replacementBlock: (id) replacementBlock;
 
+- (BOOL) removePatchOfClass: (Class) cls selector: (SEL) selector replacementBlock: (id) replacementBlock;
+- (BOOL) removePatchOfInstancesWithClass: (Class) cls selector: (SEL) selector replacementBlock: (id) replacementBlock;
+- (BOOL) setEnabled: (BOOL) enabled forPatchOfClass: (Class) cls selector: (SEL) selector replacementBlock: (id) replacementBlock;
+- (BOOL) setEnabled: (BOOL) enabled forPatchOfInstancesWithClass: (Class) cls selector: (SEL) selector replacementBlock: (id) replacementBlock;
+
+- (BOOL) observeClass: (Class) cls selector: (SEL) selector observer: (PLPatchObserver) observer context: (void *) context;
+- (BOOL) observeInstancesWithClass: (Class) cls selector: (SEL) selector observer: (PLPatchObserver) observer context: (void *) context;
+
+- (void *) interposeFunction: (void *) function preHook: (PLPatchInterposePreHook) preHook postHook: (PLPatchInterposePostHook) postHook context: (void *) context;
+
 - (void) patchFutureClassWithName: (NSString *) className selector: (SEL) selector replacementBlock: (id) replacementBlock;
 - (void) patchInstancesWithFutureClassName: (NSString *) className selector: (SEL) selector replacementBlock: (id) replacementBlock;
 
 - (void) rebindSymbol: (NSString *) symbol fromImage: (NSString *) library replacementAddress: (uintptr_t) replacementAddress;
+- (void) rebindSymbol: (NSString *) symbol fromImage: (NSString *) library replacementAddress: (uintptr_t) replacementAddress imageFilter: (PLPatchImageFilter *) imageFilter;
+- (void) rebindSymbol: (NSString *) symbol fromImage: (NSString *) library replacementAddress: (uintptr_t) replacementAddress importers: (NSArray *) importers;
+- (void) rebindSymbol: (NSString *) symbol fromImage: (NSString *) library replacementAddress: (uintptr_t) replacementAddress importerPredicate: (PLPatchImagePredicate) importerPredicate;
 - (void) rebindSymbol: (NSString *) symbol replacementAddress: (uintptr_t) replacementAddress;
+- (BOOL) rebindSymbol: (NSString *) symbol fromImage: (NSString *) library replacementBlock: (id) replacementBlock;
+- (BOOL) rebindSymbol: (NSString *) symbol replacementBlock: (id) replacementBlock;
+
+- (BOOL) restoreSymbol: (NSString *) symbol fromImage: (NSString *) library;
+- (BOOL) restoreSymbol: (NSString *) symbol;
+
+- (void) setImageFilter: (PLPatchImageFilter *) imageFilter;
+
+- (void) setBatchImageLoads: (BOOL) batchImageLoads;
+- (void) flushImageLoads;
+
+- (BOOL) applyPatchSet: (PLPatchSet *) patchSet;
+
+- (PLPatchCompletion *) asyncRebindSymbol: (NSString *) symbol fromImage: (NSString *) library replacementAddress: (uintptr_t) replacementAddress;
+- (PLPatchCompletion *) asyncRebindSymbol: (NSString *) symbol fromImage: (NSString *) library replacementAddress: (uintptr_t) replacementAddress imageFilter: (PLPatchImageFilter *) imageFilter;
+- (PLPatchCompletion *) asyncApplyPatchSet: (PLPatchSet *) patchSet;
+- (PLPatchCompletion *) allImagesProcessed;
 
 @end
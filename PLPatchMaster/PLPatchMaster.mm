@@ -111,9 +111,15 @@ NSString *kPLPatchImageLibSystem = @"/usr/lib/libSystem.B.dylib";
  * @param cls The class to patch.
  * @param selector The selector to patch.
  * @param replacementBlock The new implementation for @a selector. The first parameter must be a pointer to PLPatchIMP; the
- * remainder of the parameters must match the original method.
+ * remainder of the parameters must match the original method. Alternatively, the block may use the register ABI
+ * described by PLPatchIMPSlot.
+ *
+ * If @a selector has already been patched, @a replacementBlock is atomically inserted at the head of the method's
+ * chain of patches; its PLPatchIMPFoward() will call the previously registered block, which in turn forwards to the
+ * original implementation.
  *
- * @return Returns YES on success, or NO if @a selector is not a defined @a cls method.
+ * @return Returns YES on success, or NO if @a selector is not a defined @a cls method, or @a replacementBlock uses
+ * the register ABI and is not supported on the current architecture.
  */
 - (BOOL) patchClass: (Class) cls selector: (SEL) selector replacementBlock: (id) replacementBlock {
     return [_impl patchClass: cls selector: selector replacementBlock: replacementBlock];
@@ -125,14 +131,148 @@ NSString *kPLPatchImageLibSystem = @"/usr/lib/libSystem.B.dylib";
  * @param cls The class to patch.
  * @param selector The selector to patch.
  * @param replacementBlock The new implementation for @a selector. The first parameter must be a pointer to PLPatchIMP; the
- * remainder of the parameters must match the original method.
+ * remainder of the parameters must match the original method. Alternatively, the block may use the register ABI
+ * described by PLPatchIMPSlot.
  *
- * @return Returns YES on success, or NO if @a selector is not a defined @a cls instance method.
+ * If @a selector has already been patched, @a replacementBlock is atomically inserted at the head of the method's
+ * chain of patches; its PLPatchIMPFoward() will call the previously registered block, which in turn forwards to the
+ * original implementation.
+ *
+ * @return Returns YES on success, or NO if @a selector is not a defined @a cls instance method, or @a replacementBlock
+ * uses the register ABI and is not supported on the current architecture.
  */
 - (BOOL) patchInstancesWithClass: (Class) cls selector: (SEL) selector replacementBlock: (id) replacementBlock {
     return [_impl patchInstancesWithClass: cls selector: selector replacementBlock: replacementBlock];
 }
 
+/**
+ * Remove a block patch of the class method @a selector of @a cls, leaving any other patches of @a selector in place.
+ * The patch is unlinked from the method's chain of patches with a single atomic store.
+ *
+ * @param cls The patched class.
+ * @param selector The patched selector.
+ * @param replacementBlock The replacement block previously passed to patchClass:selector:replacementBlock:. As blocks
+ * are copied when registered, this must be the same heap-allocated (or global) block instance.
+ *
+ * @return Returns YES on success, or NO if @a replacementBlock is not registered for @a selector.
+ */
+- (BOOL) removePatchOfClass: (Class) cls selector: (SEL) selector replacementBlock: (id) replacementBlock {
+    return [_impl removePatchOfClass: cls selector: selector replacementBlock: replacementBlock];
+}
+
+/**
+ * Remove a block patch of the instance method @a selector of @a cls, leaving any other patches of @a selector in
+ * place. The patch is unlinked from the method's chain of patches with a single atomic store.
+ *
+ * @param cls The patched class.
+ * @param selector The patched selector.
+ * @param replacementBlock The replacement block previously passed to patchInstancesWithClass:selector:replacementBlock:.
+ * As blocks are copied when registered, this must be the same heap-allocated (or global) block instance.
+ *
+ * @return Returns YES on success, or NO if @a replacementBlock is not registered for @a selector.
+ */
+- (BOOL) removePatchOfInstancesWithClass: (Class) cls selector: (SEL) selector replacementBlock: (id) replacementBlock {
+    return [_impl removePatchOfInstancesWithClass: cls selector: selector replacementBlock: replacementBlock];
+}
+
+/**
+ * Enable or disable a block patch of the class method @a selector of @a cls. A disabled patch forwards directly to the
+ * next patch (or the original implementation) without calling its replacement block.
+ *
+ * Toggling a patch is a single atomic store to the patch's trampoline; the method implementation is not modified,
+ * and the patch may be safely toggled while the method is in use.
+ *
+ * @param enabled YES if the patch should be enabled, NO if it should be disabled.
+ * @param cls The patched class.
+ * @param selector The patched selector.
+ * @param replacementBlock The replacement block previously passed to patchClass:selector:replacementBlock:. As blocks
+ * are copied when registered, this must be the same heap-allocated (or global) block instance.
+ *
+ * @return Returns YES on success, or NO if @a replacementBlock is not registered for @a selector.
+ */
+- (BOOL) setEnabled: (BOOL) enabled forPatchOfClass: (Class) cls selector: (SEL) selector replacementBlock: (id) replacementBlock {
+    return [_impl setEnabled: enabled forPatchOfClass: cls selector: selector replacementBlock: replacementBlock];
+}
+
+/**
+ * Enable or disable a block patch of the instance method @a selector of @a cls. A disabled patch forwards directly to
+ * the next patch (or the original implementation) without calling its replacement block.
+ *
+ * Toggling a patch is a single atomic store to the patch's trampoline; the method implementation is not modified,
+ * and the patch may be safely toggled while the method is in use.
+ *
+ * @param enabled YES if the patch should be enabled, NO if it should be disabled.
+ * @param cls The patched class.
+ * @param selector The patched selector.
+ * @param replacementBlock The replacement block previously passed to patchInstancesWithClass:selector:replacementBlock:.
+ * As blocks are copied when registered, this must be the same heap-allocated (or global) block instance.
+ *
+ * @return Returns YES on success, or NO if @a replacementBlock is not registered for @a selector.
+ */
+- (BOOL) setEnabled: (BOOL) enabled forPatchOfInstancesWithClass: (Class) cls selector: (SEL) selector replacementBlock: (id) replacementBlock {
+    return [_impl setEnabled: enabled forPatchOfInstancesWithClass: cls selector: selector replacementBlock: replacementBlock];
+}
+
+/**
+ * Observe the class method @a selector of @a cls. The observer is called with the message receiver and selector,
+ * after which the original implementation is tail-called with all arguments intact; unlike a replacement block, an
+ * observer requires neither a PLPatchIMP frame nor an explicit call to PLPatchIMPFoward().
+ *
+ * The observer is called before the original implementation, and must not assume any particular method
+ * signature. Observe-only patches are supported on x86-64 and ARM64.
+ *
+ * @param cls The class to patch.
+ * @param selector The selector to observe.
+ * @param observer The observer function.
+ * @param context The context argument to be passed to @a observer.
+ *
+ * @return Returns YES on success, or NO if @a selector is not a defined @a cls method, or observe-only patches
+ * are not supported on the current architecture.
+ */
+- (BOOL) observeClass: (Class) cls selector: (SEL) selector observer: (PLPatchObserver) observer context: (void *) context {
+    return [_impl observeClass: cls selector: selector observer: observer context: context];
+}
+
+/**
+ * Observe the instance method @a selector of @a cls. The observer is called with the message receiver and selector,
+ * after which the original implementation is tail-called with all arguments intact.
+ *
+ * The observer is called before the original implementation, and must not assume any particular method
+ * signature. Observe-only patches are supported on x86-64 and ARM64.
+ *
+ * @param cls The class to patch.
+ * @param selector The selector to observe.
+ * @param observer The observer function.
+ * @param context The context argument to be passed to @a observer.
+ *
+ * @return Returns YES on success, or NO if @a selector is not a defined @a cls instance method, or observe-only
+ * patches are not supported on the current architecture.
+ */
+- (BOOL) observeInstancesWithClass: (Class) cls selector: (SEL) selector observer: (PLPatchObserver) observer context: (void *) context {
+    return [_impl observeInstancesWithClass: cls selector: selector observer: observer context: context];
+}
+
+/**
+ * Return an entry point that may be called in place of @a function, with any signature supported by the platform
+ * calling convention. Each call is routed through @a preHook, which may inspect and modify the argument
+ * registers, then @a function, and finally @a postHook, which may inspect and modify the return registers.
+ *
+ * The returned entry point is suitable for use with rebindSymbol:fromImage:replacementAddress:. Interposed
+ * calls must not be exited by unwinding (eg, via an Objective-C or C++ exception, or longjmp()). Generic
+ * interposition is currently supported on x86-64.
+ *
+ * @param function The function to be interposed.
+ * @param preHook The hook to be called prior to @a function, or NULL.
+ * @param postHook The hook to be called after @a function returns, or NULL.
+ * @param context The context argument to be passed to @a preHook and @a postHook.
+ *
+ * @return Returns the interposing entry point, or NULL if generic interposition is not supported on the current
+ * architecture. Interposing entry points are never deallocated.
+ */
+- (void *) interposeFunction: (void *) function preHook: (PLPatchInterposePreHook) preHook postHook: (PLPatchInterposePostHook) postHook context: (void *) context {
+    return [_impl interposeFunction: function preHook: preHook postHook: postHook context: context];
+}
+
 /**
  * Perform dyld-compatible symbol rebinding of all references to @a symbol defined by @a library across all current
  * and future loaded images.
@@ -145,6 +285,51 @@ NSString *kPLPatchImageLibSystem = @"/usr/lib/libSystem.B.dylib";
     [_impl rebindSymbol: symbol fromImage: library replacementAddress: replacementAddress];
 }
 
+/**
+ * Perform dyld-compatible symbol rebinding of all references to @a symbol defined by @a library across all current
+ * and future loaded images included by @a imageFilter.
+ *
+ * @param symbol The name of the symbol to patch.
+ * @param library The absolute or relative path (e.g. 'Foundation') to the library responsible for exporting the original symbol.
+ * @param replacementAddress The new address to which the symbol will be bound.
+ * @param imageFilter The filter used to select the images to be rebound, or nil to rebind all images. The filter's
+ * rules are captured at the time of the call.
+ */
+- (void) rebindSymbol: (NSString *) symbol fromImage: (NSString *) library replacementAddress: (uintptr_t) replacementAddress imageFilter: (PLPatchImageFilter *) imageFilter {
+    [_impl rebindSymbol: symbol fromImage: library replacementAddress: replacementAddress imageFilter: imageFilter];
+}
+
+/**
+ * Perform dyld-compatible symbol rebinding of references to @a symbol defined by @a library, restricted to
+ * references made by the images in @a importers. No other images will be analyzed or modified.
+ *
+ * @param symbol The name of the symbol to patch.
+ * @param library The absolute or relative path (e.g. 'Foundation') to the library responsible for exporting the original symbol.
+ * @param replacementAddress The new address to which the symbol will be bound.
+ * @param importers The paths of all images whose references should be rebound. The paths must match the image paths
+ * as reported by dyld. Images in this set that have not yet been loaded will be rebound when loaded.
+ */
+- (void) rebindSymbol: (NSString *) symbol fromImage: (NSString *) library replacementAddress: (uintptr_t) replacementAddress importers: (NSArray *) importers {
+    [_impl rebindSymbol: symbol fromImage: library replacementAddress: replacementAddress importers: importers];
+}
+
+/**
+ * Perform dyld-compatible symbol rebinding of references to @a symbol defined by @a library, restricted to
+ * references made by images for which @a importerPredicate returns YES. The predicate is evaluated before the
+ * image is analyzed; images it rejects are not analyzed or modified.
+ *
+ * @param symbol The name of the symbol to patch.
+ * @param library The absolute or relative path (e.g. 'Foundation') to the library responsible for exporting the original symbol.
+ * @param replacementAddress The new address to which the symbol will be bound.
+ * @param importerPredicate The predicate used to select importing images. It may be called from any thread, and
+ * must not call back into PLPatchMaster. Its result is cached per image, but it may be evaluated more than once --
+ * including concurrently -- for the same image; it must be thread-safe, and must return the same result for any
+ * given image.
+ */
+- (void) rebindSymbol: (NSString *) symbol fromImage: (NSString *) library replacementAddress: (uintptr_t) replacementAddress importerPredicate: (PLPatchImagePredicate) importerPredicate {
+    [_impl rebindSymbol: symbol fromImage: library replacementAddress: replacementAddress importerPredicate: importerPredicate];
+}
+
 /**
  * Perform dyld-compatible symbol rebinding of all references to @a symbol defined by *any* library across all current
  * and future loaded images.
@@ -158,4 +343,186 @@ NSString *kPLPatchImageLibSystem = @"/usr/lib/libSystem.B.dylib";
     [_impl rebindSymbol: symbol replacementAddress: replacementAddress];
 }
 
+/**
+ * Perform dyld-compatible symbol rebinding of all references to @a symbol defined by @a library across all current
+ * and future loaded images, binding each reference to a trampoline that calls @a replacementBlock.
+ *
+ * The block's first argument is a PLPatchFunction pointer referencing the original function, followed by all of
+ * the original function's arguments; the original may be called via PLPatchFunctionForward(). This allows
+ * stateful replacements to be implemented without global state:
+ *
+ * @code
+ * __block NSUInteger count = 0;
+ * [master rebindSymbol: @"_write" fromImage: kPLPatchImageLibSystem replacementBlock: ^(PLPatchFunction *patch, int fd, const void *buf, size_t nbyte) {
+ *     count++;
+ *     return PLPatchFunctionForward(patch, ssize_t (*)(int, const void *, size_t), fd, buf, nbyte);
+ * }];
+ * @endcode
+ *
+ * Symbol replacement blocks are supported on x86-64 and ARM64, for non-variadic functions whose arguments are all
+ * passed in registers: at most four (x86-64) or six (ARM64) integer or pointer arguments, and at most eight floating
+ * point arguments. Structure, union, and long double arguments are not supported. On x86-64, functions that return
+ * a structure in memory are not supported. Blocks that do not meet these requirements are rejected.
+ *
+ * Rebinding trampolines are never deallocated, including after a call to restoreSymbol:fromImage:.
+ *
+ * @param symbol The name of the symbol to patch.
+ * @param library The install name (e.g. '/System/Library/Frameworks/Foundation.framework/Versions/C/Foundation') of
+ * the library responsible for exporting the original symbol.
+ * @param replacementBlock The replacement block.
+ *
+ * @return Returns YES on success, or NO if @a symbol could not be resolved, or @a replacementBlock is not supported
+ * on the current architecture.
+ */
+- (BOOL) rebindSymbol: (NSString *) symbol fromImage: (NSString *) library replacementBlock: (id) replacementBlock {
+    return [_impl rebindSymbol: symbol fromImage: library replacementBlock: replacementBlock];
+}
+
+/**
+ * Perform dyld-compatible symbol rebinding of all references to @a symbol defined by *any* library across all current
+ * and future loaded images, binding each reference to a trampoline that calls @a replacementBlock.
+ *
+ * @param symbol The name of the symbol to patch.
+ * @param replacementBlock The replacement block; see rebindSymbol:fromImage:replacementBlock:.
+ *
+ * @return Returns YES on success, or NO if @a symbol could not be resolved, or @a replacementBlock is not supported
+ * on the current architecture.
+ */
+- (BOOL) rebindSymbol: (NSString *) symbol replacementBlock: (id) replacementBlock {
+    return [_impl rebindSymbol: symbol replacementBlock: replacementBlock];
+}
+
+/**
+ * Remove all rebindings of @a symbol registered for @a library, restoring all bind sites that were overwritten
+ * by the rebindings to their original values. Images loaded in the future will no longer be rebound.
+ *
+ * The overwritten bind sites are recorded when a rebinding is applied; restoring them does not require
+ * re-evaluating any image's symbol bindings.
+ *
+ * @param symbol The name of the rebound symbol.
+ * @param library The library path that was supplied when the symbol was rebound.
+ *
+ * @return Returns YES if any matching rebinding was found, or NO otherwise.
+ */
+- (BOOL) restoreSymbol: (NSString *) symbol fromImage: (NSString *) library {
+    return [_impl restoreSymbol: symbol fromImage: library];
+}
+
+/**
+ * Remove all rebindings of @a symbol that were registered for *any* library via
+ * rebindSymbol:replacementAddress:, restoring all bind sites that were overwritten by the rebindings to their
+ * original values.
+ *
+ * @param symbol The name of the rebound symbol.
+ *
+ * @return Returns YES if any matching rebinding was found, or NO otherwise.
+ */
+- (BOOL) restoreSymbol: (NSString *) symbol {
+    return [_impl restoreSymbol: symbol];
+}
+
+/**
+ * Restrict all symbol rebinding -- including rebinding of images loaded in the future -- to the images
+ * included by @a imageFilter. This may be used to avoid the cost of rebinding images that will never require
+ * patching, such as system libraries. Images that have already been rebound are not modified.
+ *
+ * @param imageFilter The filter used to select the images to be rebound, or nil to rebind all images. The
+ * filter's rules are captured at the time of the call.
+ */
+- (void) setImageFilter: (PLPatchImageFilter *) imageFilter {
+    [_impl setImageFilter: imageFilter];
+}
+
+/**
+ * Enable or disable batched processing of image loads.
+ *
+ * When enabled, newly loaded images are queued and patched together on a dedicated serial queue, rather than
+ * synchronously from within the dynamic linker's image load callback. This reduces the per-image overhead when
+ * a framework load triggers a burst of dependent image loads.
+ *
+ * As patches are applied asynchronously, callers that require a newly loaded image to be patched before
+ * proceeding -- for example, immediately after calling dlopen() -- must call flushImageLoads.
+ *
+ * @param batchImageLoads YES to enable batching, NO to patch newly loaded images synchronously.
+ */
+- (void) setBatchImageLoads: (BOOL) batchImageLoads {
+    [_impl setBatchImageLoads: batchImageLoads];
+}
+
+/**
+ * Apply all patches to any queued image loads, returning once every image loaded prior to the call
+ * has been patched. If no image loads are queued, this returns immediately.
+ */
+- (void) flushImageLoads {
+    [_impl flushImageLoads];
+}
+
+/**
+ * Apply all method patches and symbol rebindings registered with @a patchSet as a single transaction.
+ *
+ * All patches are validated prior to modifying any runtime state, and are then applied together. If any patch
+ * can not be applied, all changes made by the patch set are rolled back, leaving the runtime state unmodified.
+ *
+ * @param patchSet The patch set to apply.
+ *
+ * @return Returns YES on success, or NO if any patch in @a patchSet could not be applied.
+ */
+- (BOOL) applyPatchSet: (PLPatchSet *) patchSet {
+    return [_impl applyPatchSet: patchSet];
+}
+
+/**
+ * Asynchronously perform dyld-compatible symbol rebinding of all references to @a symbol defined by @a library
+ * across all current and future loaded images.
+ *
+ * The sweep over the loaded images is performed on a background queue, allowing launch-critical threads to register
+ * a rebinding without waiting for it to be applied. Asynchronous operations are performed in the order they were
+ * submitted.
+ *
+ * @param symbol The name of the symbol to patch.
+ * @param library The install name of the library responsible for exporting the original symbol.
+ * @param replacementAddress The new address to which the symbol will be bound.
+ *
+ * @return A completion handle that may be used to wait for the rebinding to be applied.
+ */
+- (PLPatchCompletion *) asyncRebindSymbol: (NSString *) symbol fromImage: (NSString *) library replacementAddress: (uintptr_t) replacementAddress {
+    return [_impl asyncRebindSymbol: symbol fromImage: library replacementAddress: replacementAddress imageFilter: nil];
+}
+
+/**
+ * Asynchronously perform dyld-compatible symbol rebinding of all references to @a symbol defined by @a library
+ * across all current and future loaded images included by @a imageFilter.
+ *
+ * @param symbol The name of the symbol to patch.
+ * @param library The install name of the library responsible for exporting the original symbol.
+ * @param replacementAddress The new address to which the symbol will be bound.
+ * @param imageFilter The filter used to select the images to be rebound, or nil to rebind all images. The filter's
+ * rules are captured at the time of the call.
+ *
+ * @return A completion handle that may be used to wait for the rebinding to be applied.
+ */
+- (PLPatchCompletion *) asyncRebindSymbol: (NSString *) symbol fromImage: (NSString *) library replacementAddress: (uintptr_t) replacementAddress imageFilter: (PLPatchImageFilter *) imageFilter {
+    return [_impl asyncRebindSymbol: symbol fromImage: library replacementAddress: replacementAddress imageFilter: imageFilter];
+}
+
+/**
+ * Asynchronously apply all method patches and symbol rebindings registered with @a patchSet as a single
+ * transaction. The patch set must not be modified after it has been submitted.
+ *
+ * @param patchSet The patch set to apply.
+ *
+ * @return A completion handle; its -succeeded result reports whether the patch set was applied.
+ */
+- (PLPatchCompletion *) asyncApplyPatchSet: (PLPatchSet *) patchSet {
+    return [_impl asyncApplyPatchSet: patchSet];
+}
+
+/**
+ * Return a completion handle that completes once all previously submitted asynchronous operations have been
+ * applied, and all images loaded prior to the call have been processed.
+ */
+- (PLPatchCompletion *) allImagesProcessed {
+    return [_impl allImagesProcessed];
+}
+
 @end
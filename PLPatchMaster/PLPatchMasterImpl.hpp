@@ -28,17 +28,114 @@
 
 #import <Foundation/Foundation.h>
 #import <libkern/OSAtomic.h>
+#import <pthread.h>
 #import "SymbolBinder.hpp"
+#import "ImageFilter.hpp"
+#import "BindLog.hpp"
+#import "ImageEventSource.hpp"
+#import "PLPatchImageFilter.h"
+#import "PLPatchCompletion.h"
+#import "PLPatchMaster.h"
+
+#import <objc/runtime.h>
+
+#import <map>
+#import <memory>
+#import <mutex>
+#import <unordered_map>
+#import <unordered_set>
 
 using namespace patchmaster;
 
+/**
+ * @internal
+ *
+ * A single symbol-based patch; the fully qualified two-level SymbolName, the patch value, an
+ * optional filter restricting the images to which the patch applies, and the log of all bind
+ * sites overwritten by the patch.
+ */
+typedef std::tuple<SymbolName, uintptr_t, std::shared_ptr<const ImageFilter>, std::shared_ptr<BindLog>> SymbolPatch;
+
 /**
  * @internal
  *
  * Table of symbol-based patches; maps the single-level symbol name to the
  * fully qualified two-level SymbolNames and associated patch value.
  */
-typedef std::map<std::string, std::vector<std::tuple<SymbolName, uintptr_t>>> PatchTable;
+typedef std::map<std::string, std::vector<SymbolPatch>> PatchTable;
+
+/**
+ * @internal
+ *
+ * A loaded image awaiting patching.
+ */
+struct LoadedImage {
+    /** The image header. */
+    const struct mach_header *header;
+    
+    /** The image path, or an empty string if unknown. */
+    std::string path;
+};
+
+/**
+ * @internal
+ *
+ * The symbol rebinding state of a single loaded image.
+ *
+ * All rebinding of an image -- whether on image load, or by a sweep over the loaded images -- is performed with
+ * the image's lock held, against the most recently published patch table snapshot. Only patches that have not
+ * yet been applied to the image are written, ensuring that patches are always written to the image's bind sites
+ * in registration order.
+ *
+ * The state is created when the image's load is observed, and is marked as unloaded (with the lock held) when
+ * the image's unload is observed; an unloaded image must not be rebound.
+ */
+struct ImageBindState {
+    /** Lock that must be held when rebinding the image, or when accessing applied or unloaded. */
+    std::mutex lock;
+    
+    /** The bind logs of all patches that have been applied to (or are not applicable to) the image. */
+    std::unordered_set<std::shared_ptr<BindLog>> applied;
+    
+    /** True if the image has been unloaded. */
+    bool unloaded = false;
+};
+
+/**
+ * @internal
+ *
+ * The chain of block patches applied to a single method. The method's implementation is the chain's dispatch
+ * entry, which is installed once and tail-calls the first hook's trampoline; each hook forwards (via
+ * PLPatchIMPFoward) to the next hook's trampoline, and the final hook forwards to the method's original
+ * implementation.
+ *
+ * Hooks are added and removed by atomically relinking a single trampoline; the method's implementation is never
+ * modified once the entry has been installed.
+ */
+struct MethodChain {
+    /** The method's original implementation. */
+    IMP origIMP;
+    
+    /** The chain's dispatch entry; a permanently disabled block IMP trampoline that forwards to the first hook, or to
+     * origIMP if the chain is empty. */
+    IMP entry;
+    
+    /**
+     * Immutable snapshot of the chain's hook trampolines, in call order (most recently inserted first). The snapshot is never modified once
+     * published; adding or removing a hook publishes an updated copy.
+     */
+    std::shared_ptr<const std::vector<IMP>> hooks;
+};
+
+/**
+ * @internal
+ *
+ * Table of method chains; maps the patched class (or metaclass, for class methods) and selector to the method's
+ * chain of block patches.
+ */
+typedef std::map<std::pair<Class, SEL>, MethodChain> MethodChainTable;
+
+@class PLPatchSet;
 
 @interface PLPatchMasterImpl : NSObject {
     /** Lock that must be held when mutating or accessing internal state */
@@ -46,11 +143,30 @@ typedef std::map<std::string, std::vector<std::tuple<SymbolName, uintptr_t>>> Pa
     
     IMP _callbackFunc;
     
+    /** Lock that must be held when updating _symbolPatches or _imageFilter. Readers do not acquire this lock. */
+    pthread_mutex_t _symbolLock;
+    
     /**
-     * Table of symbol-based patches; maps the single-level symbol name to the
+     * Immutable snapshot of the table of symbol-based patches; maps the single-level symbol name to the
      * fully qualified two-level SymbolNames and associated patch value.
+     *
+     * Must be read via std::atomic_load(), and replaced via std::atomic_store(). The table itself is never
+     * modified once published; writers publish an updated copy, and readers retain the snapshot they loaded
+     * until they have finished with it. Snapshots used to rebind an image must be loaded with the image's
+     * ImageBindState lock held.
      */
-    PatchTable _symbolPatches;
+    std::shared_ptr<const PatchTable> _symbolPatches;
+    
+    /** Lock that must be held when accessing _imageBindStates. */
+    OSSpinLock _imageBindStateLock;
+    
+    /** Maps image header -> symbol rebinding state, for every loaded image. Entries are added when an image load
+     * is observed, and removed when the image is unloaded. */
+    std::unordered_map<const void *, std::shared_ptr<ImageBindState>> _imageBindStates;
+    
+    /** If non-NULL, restricts all symbol rebinding to the images included by this filter. Must be read via
+     * std::atomic_load(), and replaced via std::atomic_store(). */
+    std::shared_ptr<const ImageFilter> _imageFilter;
     
     /** Maps class -> set -> selector names. Used to keep track of patches that have already been made,
      * and thus do not require a _restoreBlock to be registered */
@@ -60,9 +176,38 @@ typedef std::map<std::string, std::vector<std::tuple<SymbolName, uintptr_t>>> Pa
      * and thus do not require a _restoreBlock to be registered */
     NSMutableDictionary *_instancePatches;
     
-    /** An array of blocks to be executed on dynamic library load; the blocks are responsible
-     * for applying any pending patches to the newly loaded library */
-    NSMutableArray *_pendingPatches;
+    /** Method chains for all block-patched methods. Must be accessed with _lock held. */
+    MethodChainTable _methodChains;
+    
+    /** Our image event listener, registered with the shared ImageEventSource. */
+    ImageEventListener *_imageListener;
+    
+    /** Lock that must be held when accessing _batchImageLoads, _queuedImages, or _drainUnloadedImages. */
+    OSSpinLock _queueLock;
+    
+    /** If true, image loads are queued and processed in batches on _imageLoadQueue. */
+    BOOL _batchImageLoads;
+    
+    /** Loaded images awaiting processing on _imageLoadQueue. */
+    std::vector<LoadedImage> _queuedImages;
+    
+    /** Images unloaded on _imageLoadQueue while a batch was being processed; these are skipped by the batch. */
+    std::unordered_set<const struct mach_header *> _drainUnloadedImages;
+    
+    /** Serial queue on which batched image loads are processed. */
+    dispatch_queue_t _imageLoadQueue;
+    
+    /** Serial queue on which asynchronous patch operations are performed. */
+    dispatch_queue_t _patchQueue;
+    
+    /** Maps class name -> array of blocks to be executed when a class with that name is loaded; the blocks
+     * are responsible for applying any pending patches to the newly loaded class. */
+    NSMutableDictionary *_pendingPatches;
+    
+    /** An array of pending patch blocks targeting classes that have already been loaded, but that do not (yet)
+     * implement the target selector. These are executed on every dynamic library load, as the selector may be
+     * registered by a category in any image. */
+    NSMutableArray *_pendingSelectorPatches;
     
     /* An array of zero-arg blocks that, when executed, will reverse
      * all previously patched methods. */
@@ -72,10 +217,39 @@ typedef std::map<std::string, std::vector<std::tuple<SymbolName, uintptr_t>>> Pa
 - (BOOL) patchClass: (Class) cls selector: (SEL) selector replacementBlock: (id) replacementBlock;
 - (BOOL) patchInstancesWithClass: (Class) cls selector: (SEL) selector replacementBlock: (id) replacementBlock;
 
+- (BOOL) removePatchOfClass: (Class) cls selector: (SEL) selector replacementBlock: (id) replacementBlock;
+- (BOOL) removePatchOfInstancesWithClass: (Class) cls selector: (SEL) selector replacementBlock: (id) replacementBlock;
+- (BOOL) setEnabled: (BOOL) enabled forPatchOfClass: (Class) cls selector: (SEL) selector replacementBlock: (id) replacementBlock;
+- (BOOL) setEnabled: (BOOL) enabled forPatchOfInstancesWithClass: (Class) cls selector: (SEL) selector replacementBlock: (id) replacementBlock;
+
+- (BOOL) observeClass: (Class) cls selector: (SEL) selector observer: (PLPatchObserver) observer context: (void *) context;
+- (BOOL) observeInstancesWithClass: (Class) cls selector: (SEL) selector observer: (PLPatchObserver) observer context: (void *) context;
+
+- (void *) interposeFunction: (void *) function preHook: (PLPatchInterposePreHook) preHook postHook: (PLPatchInterposePostHook) postHook context: (void *) context;
+
 - (void) patchFutureClassWithName: (NSString *) className selector: (SEL) selector replacementBlock: (id) replacementBlock;
 - (void) patchInstancesWithFutureClassName: (NSString *) className selector: (SEL) selector replacementBlock: (id) replacementBlock;
 
 - (void) rebindSymbol: (NSString *) symbol fromImage: (NSString *) library replacementAddress: (uintptr_t) replacementAddress;
+- (void) rebindSymbol: (NSString *) symbol fromImage: (NSString *) library replacementAddress: (uintptr_t) replacementAddress imageFilter: (PLPatchImageFilter *) imageFilter;
+- (void) rebindSymbol: (NSString *) symbol fromImage: (NSString *) library replacementAddress: (uintptr_t) replacementAddress importers: (NSArray *) importers;
+- (void) rebindSymbol: (NSString *) symbol fromImage: (NSString *) library replacementAddress: (uintptr_t) replacementAddress importerPredicate: (PLPatchImagePredicate) importerPredicate;
 - (void) rebindSymbol: (NSString *) symbol replacementAddress: (uintptr_t) replacementAddress;
+- (BOOL) rebindSymbol: (NSString *) symbol fromImage: (NSString *) library replacementBlock: (id) replacementBlock;
+- (BOOL) rebindSymbol: (NSString *) symbol replacementBlock: (id) replacementBlock;
+
+- (BOOL) restoreSymbol: (NSString *) symbol fromImage: (NSString *) library;
+- (BOOL) restoreSymbol: (NSString *) symbol;
+
+- (void) setImageFilter: (PLPatchImageFilter *) imageFilter;
+
+- (void) setBatchImageLoads: (BOOL) batchImageLoads;
+- (void) flushImageLoads;
+
+- (BOOL) applyPatchSet: (PLPatchSet *) patchSet;
+
+- (PLPatchCompletion *) asyncRebindSymbol: (NSString *) symbol fromImage: (NSString *) library replacementAddress: (uintptr_t) replacementAddress imageFilter: (PLPatchImageFilter *) imageFilter;
+- (PLPatchCompletion *) asyncApplyPatchSet: (PLPatchSet *) patchSet;
+- (PLPatchCompletion *) allImagesProcessed;
 
 @end
@@ -28,19 +28,25 @@
 
 #import "PLPatchMasterImpl.hpp"
 #import "PLPatchMaster.h"
-
-extern "C" {
-#define PL_BLOCKIMP_PRIVATE 1 // Required for the PLBlockIMP trampoline API
-#import <PLBlockIMP/trampoline_table.h>
-}
+#import "PLPatchSetPrivate.h"
+#import "PLPatchImageFilterPrivate.h"
+#import "PLPatchCompletionPrivate.h"
+#import "BindSiteWriter.hpp"
+#import "TrampolineCache.hpp"
+#import "Interposer.hpp"
 
 #import "PLBlockLayout.h"
 #import "PMLog.h"
 
 #import <mach-o/dyld.h>
+#import <dlfcn.h>
 
 #import <objc/runtime.h>
 
+#import <algorithm>
+#import <iterator>
+#import <unordered_set>
+
 /* Include the generated PLBlockIMP headers */
 extern "C" {
 #ifdef __i386__
@@ -57,90 +63,387 @@ extern "C" {
 #else
 #error Unsupported Architecture
 #endif
+
+/* Observe-only trampolines are only available on x86-64 and ARM64 */
+#if defined(__x86_64__)
+#include "observe_x86_64.h"
+#include "observe_x86_64_stret.h"
+#define OBSERVE_TABLE_SUPPORTED 1
+#elif defined(__arm64__)
+#include "observe_arm64.h"
+#define OBSERVE_TABLE_SUPPORTED 1
+#else
+#define OBSERVE_TABLE_SUPPORTED 0
+#endif
+
+/* Symbol replacement block trampolines are only available on x86-64 and ARM64. Each shifts the integer argument
+ * registers by two, and is limited to functions whose arguments are all passed in registers: at most
+ * SYMBOL_TABLE_MAX_INT_ARGS integer arguments, and SYMBOL_TABLE_MAX_VECTOR_ARGS floating point arguments. */
+#if defined(__x86_64__)
+#include "symbol_x86_64.h"
+#define SYMBOL_TABLE_SUPPORTED 1
+#define SYMBOL_TABLE_MAX_INT_ARGS 4
+#define SYMBOL_TABLE_MAX_VECTOR_ARGS 8
+#elif defined(__arm64__)
+#include "symbol_arm64.h"
+#define SYMBOL_TABLE_SUPPORTED 1
+#define SYMBOL_TABLE_MAX_INT_ARGS 6
+#define SYMBOL_TABLE_MAX_VECTOR_ARGS 8
+#else
+#define SYMBOL_TABLE_SUPPORTED 0
+#endif
+
+/* Register ABI PLPatchIMP trampolines are only available on x86-64 and ARM64. Each shifts the integer argument
+ * registers following _cmd by one, and is limited to methods with at most REGISTER_TABLE_MAX_ARGS integer
+ * arguments (excluding self and _cmd). */
+#if defined(__x86_64__)
+#include "blockreg_x86_64.h"
+#define REGISTER_TABLE_SUPPORTED 1
+#define REGISTER_TABLE_MAX_ARGS 3
+#elif defined(__arm64__)
+#include "blockreg_arm64.h"
+#define REGISTER_TABLE_SUPPORTED 1
+#define REGISTER_TABLE_MAX_ARGS 5
+#else
+#define REGISTER_TABLE_SUPPORTED 0
+#endif
 }
 
 /* The ARM64 ABI does not require (or support) the _stret objc_msgSend variant */
 #ifdef __arm64__
 #define STRET_TABLE_REQUIRED 0
 #define STRET_TABLE_CONFIG pl_blockimp_patch_table_page_config
-#define STRET_TABLE blockimp_table
 #else
 #define STRET_TABLE_REQUIRED 1
 #define STRET_TABLE_CONFIG pl_blockimp_patch_table_stret_page_config
-#define STRET_TABLE blockimp_table_stret
 #endif
 
-/** Notification sent (synchronously) when an image is added. */
-static NSString *PLPatchMasterImageDidLoadNotification = @"PLPatchMasterImageDidLoadNotification";
+static bool perform_dyld_rebinding (const PatchTable &patches, const std::unordered_set<std::shared_ptr<BindLog>> &applied, const char *image_name, const struct mach_header *mh);
+static void restore_symbol_patches (PatchTable &table, const std::function<bool(const SymbolPatch &patch)> &remove);
 
-/** Notification user-info key containing the mach header pointer for a newly added image */
-static NSString *PLPatchMasterMachHeaderKey = @"PLPatchMasterMachHeaderKey";
+/* Global lock for our interned symbol name strings. */
+static pthread_mutex_t symbol_strings_lock = PTHREAD_MUTEX_INITIALIZER;
 
-static void perform_dyld_rebinding (const PatchTable &patches, const char *image_name, const struct mach_header *mh);
+/* Interned symbol name strings; SymbolName does not take ownership of its strings, and these must remain valid for
+ * the lifetime of any registered patch. */
+static std::unordered_set<std::string> *symbol_strings = NULL;
 
-/* Global lock for our mutable trampoline state. Must be held when accessing the trampoline tables. */
-static pthread_mutex_t blockimp_lock = PTHREAD_MUTEX_INITIALIZER;
+/* Queue-specific key used to identify a PLPatchMasterImpl's _imageLoadQueue; the value is the owning instance. */
+static char image_load_queue_key;
 
-/* Trampoline tables for objc_msgSend() dispatch. */
-static pl_trampoline_table *blockimp_table = NULL;
+/**
+ * PLPatchIMP block IMP trampoline types. All types share a single configuration layout: block, disabled flag,
+ * original IMP, original SEL.
+ */
+enum patch_imp_type {
+    /** objc_msgSend() dispatch, passing a PLPatchIMP to the block. */
+    PATCH_IMP_MSGSEND = 0,
+
+    /** objc_msgSend_stret() dispatch, passing a PLPatchIMP to the block. */
+    PATCH_IMP_STRET = 1,
+
+    /** objc_msgSend() dispatch, passing a PLPatchIMPSlot and self to the block. */
+    PATCH_IMP_REGISTER = 2,
 
+    /** The number of trampoline types. */
+    PATCH_IMP_TYPE_COUNT = 3
+};
+
+/**
+ * Return the trampoline table for @a type. The tables are never deallocated.
+ */
+static TrampolineTable &blockimp_table (patch_imp_type type) {
+    static TrampolineTable *table = new TrampolineTable(&pl_blockimp_patch_table_page_config);
 #if STRET_TABLE_REQUIRED
-/* Trampoline tables for objc_msgSend_stret() dispatch. */
-static pl_trampoline_table *blockimp_table_stret = NULL;
+    static TrampolineTable *stret_table = new TrampolineTable(&STRET_TABLE_CONFIG);
+    if (type == PATCH_IMP_STRET)
+        return *stret_table;
 #endif /* STRET_TABLE_REQUIRED */
+#if REGISTER_TABLE_SUPPORTED
+    static TrampolineTable *register_table = new TrampolineTable(&pl_blockimp_register_table_page_config);
+    if (type == PATCH_IMP_REGISTER)
+        return *register_table;
+#endif /* REGISTER_TABLE_SUPPORTED */
+    
+    return *table;
+}
 
 /**
- * Create a new PLPatchIMP block IMP trampoline.
+ * Return the per-thread trampoline cache for @a type. The caches are never deallocated.
  */
-static IMP patch_imp_implementationWithBlock (id block, SEL selector, IMP origIMP) {
-    /* Allocate the appropriate trampoline type. */
-    pl_trampoline *tramp;
+static TrampolineCache &blockimp_cache (patch_imp_type type) {
+    static TrampolineCache *cache = new TrampolineCache(blockimp_table(PATCH_IMP_MSGSEND));
+#if STRET_TABLE_REQUIRED
+    static TrampolineCache *stret_cache = new TrampolineCache(blockimp_table(PATCH_IMP_STRET));
+    if (type == PATCH_IMP_STRET)
+        return *stret_cache;
+#endif /* STRET_TABLE_REQUIRED */
+#if REGISTER_TABLE_SUPPORTED
+    static TrampolineCache *register_cache = new TrampolineCache(blockimp_table(PATCH_IMP_REGISTER));
+    if (type == PATCH_IMP_REGISTER)
+        return *register_cache;
+#endif /* REGISTER_TABLE_SUPPORTED */
+    
+    return *cache;
+}
+
+/**
+ * Return true if @a block must be dispatched via an objc_msgSend_stret() trampoline.
+ */
+static bool patch_imp_requiresStret (id block) {
     struct Block_layout *bl = (__bridge struct Block_layout *) block;
-    if (bl->flags & BLOCK_USE_STRET) {
-        tramp = pl_trampoline_alloc(&STRET_TABLE_CONFIG, &blockimp_lock, &STRET_TABLE);
-    } else {
-        tramp = pl_trampoline_alloc(&pl_blockimp_patch_table_page_config, &blockimp_lock, &blockimp_table);
+    return (bl->flags & BLOCK_USE_STRET) != 0;
+}
+
+/**
+ * Return the Objective-C type encoding of @a block's signature, or NULL if the block was not compiled with a
+ * signature.
+ */
+static const char *patch_imp_getSignature (id block) {
+    struct Block_layout *bl = (__bridge struct Block_layout *) block;
+    if ((bl->flags & BLOCK_HAS_SIGNATURE) == 0)
+        return NULL;
+    
+    /* The signature follows the optional copy and dispose helpers */
+    const char **signature = (const char **) &bl->descriptor->copy;
+    if (bl->flags & BLOCK_HAS_COPY_DISPOSE)
+        signature += 2;
+    
+    return *signature;
+}
+
+/**
+ * Skip any type qualifiers (eg, const) at the start of the Objective-C type encoding @a type.
+ */
+static const char *patch_imp_skipQualifiers (const char *type) {
+    while (*type != '\0' && strchr("rnNoORV", *type) != NULL)
+        type++;
+    return type;
+}
+
+/**
+ * Return the trampoline type required by @a block. Blocks whose first parameter is a pointer to PLPatchIMPSlot use
+ * the register ABI; all others receive a PLPatchIMP.
+ */
+static patch_imp_type patch_imp_getType (id block) {
+    const char *signature = patch_imp_getSignature(block);
+    if (signature != NULL) {
+        @autoreleasepool {
+            NSMethodSignature *sig = [NSMethodSignature signatureWithObjCTypes: signature];
+            if ([sig numberOfArguments] > 1) {
+                const char *type = patch_imp_skipQualifiers([sig getArgumentTypeAtIndex: 1]);
+                if (strncmp(type, "^{PLPatchIMPSlot=", strlen("^{PLPatchIMPSlot=")) == 0)
+                    return PATCH_IMP_REGISTER;
+            }
+        }
+    }
+    
+    return patch_imp_requiresStret(block) ? PATCH_IMP_STRET : PATCH_IMP_MSGSEND;
+}
+
+/**
+ * Count the integer and floating point arguments of @a sig, starting at argument index @a first.
+ *
+ * @param sig The block signature.
+ * @param first The index of the first argument to be counted.
+ * @param[out] intArgs The number of integer (including pointer) arguments.
+ * @param[out] vectorArgs The number of floating point arguments.
+ *
+ * @return Returns false if @a sig declares an aggregate or long double argument, the register assignment of which
+ * can not be determined from the type encoding alone.
+ */
+static bool block_countArguments (NSMethodSignature *sig, NSUInteger first, NSUInteger *intArgs, NSUInteger *vectorArgs) {
+    *intArgs = 0;
+    *vectorArgs = 0;
+    
+    for (NSUInteger i = first; i < [sig numberOfArguments]; i++) {
+        const char *type = patch_imp_skipQualifiers([sig getArgumentTypeAtIndex: i]);
+        switch (type[0]) {
+            case _C_FLT:
+            case _C_DBL:
+                (*vectorArgs)++;
+                break;
+                
+            case _C_STRUCT_B:
+            case _C_UNION_B:
+            case _C_ARY_B:
+            case 'D': /* long double */
+                return false;
+                
+            default:
+                (*intArgs)++;
+                break;
+        }
+    }
+    
+    return true;
+}
+
+/**
+ * Return true if @a block may be dispatched via a trampoline of @a type. Register ABI blocks are only supported
+ * on architectures with a register ABI trampoline, may not return structures in memory on architectures that
+ * pass the structure return pointer as the first argument, and may not declare more than REGISTER_TABLE_MAX_ARGS
+ * integer arguments, or any aggregate arguments.
+ */
+static bool patch_imp_isSupported (id block, patch_imp_type type) {
+    if (type != PATCH_IMP_REGISTER)
+        return true;
+
+#if REGISTER_TABLE_SUPPORTED
+#if STRET_TABLE_REQUIRED
+    if (patch_imp_requiresStret(block)) {
+        PMLog("Register ABI patches may not return structures in memory on this architecture");
+        return false;
+    }
+#endif /* STRET_TABLE_REQUIRED */
+    
+    @autoreleasepool {
+        NSMethodSignature *sig = [NSMethodSignature signatureWithObjCTypes: patch_imp_getSignature(block)];
+        
+        /* Skip the block, PLPatchIMPSlot, and self parameters; vector registers are not shifted */
+        NSUInteger intArgs;
+        NSUInteger vectorArgs;
+        if (!block_countArguments(sig, 3, &intArgs, &vectorArgs)) {
+            PMLog("Register ABI patches may not declare aggregate or long double arguments");
+            return false;
+        }
+        
+        if (intArgs > REGISTER_TABLE_MAX_ARGS) {
+            PMLog("Register ABI patches may not declare more than %d integer arguments on this architecture", REGISTER_TABLE_MAX_ARGS);
+            return false;
+        }
     }
     
-    /* Configure the trampoline */
-    void **config = (void **) pl_trampoline_data_ptr((void *) tramp->trampoline);
-    config[0] = Block_copy((__bridge void *)block);
-    config[1] = tramp;
-    config[2] = (void *) origIMP;
-    config[3] = selector;
+    return true;
+#else
+    PMLog("Register ABI patches are not supported on this architecture");
+    return false;
+#endif /* REGISTER_TABLE_SUPPORTED */
+}
+
+/**
+ * Configure an allocated PLPatchIMP block IMP trampoline.
+ *
+ * @param table The table from which @a trampoline was allocated.
+ * @param trampoline The trampoline to configure.
+ * @param block The block to be dispatched by the trampoline.
+ * @param selector The patched selector.
+ * @param origIMP The original method implementation.
+ *
+ * @return Returns the trampoline IMP.
+ */
+static IMP patch_imp_configure (TrampolineTable &table, void *trampoline, id block, SEL selector, IMP origIMP) {
+    /* The configuration entry may be split across multiple pages; the block reference is always in the first
+     * chunk. */
+    *table.config_entry(trampoline, 0) = Block_copy((__bridge void *)block);
+    *table.config_entry(trampoline, 1) = NULL; /* Enabled */
+    *table.config_entry(trampoline, 2) = (void *) origIMP;
+    *table.config_entry(trampoline, 3) = selector;
+    
+    return (IMP) trampoline;
+}
+
+/**
+ * Configure an allocated PLPatchIMP block IMP trampoline as the dispatch entry of a method chain. The entry has no
+ * block, and is permanently disabled; it tail-calls @a target with all arguments intact, and may be used as the
+ * implementation of any method, regardless of its calling convention.
+ *
+ * @param trampoline The trampoline to configure, allocated from the PATCH_IMP_MSGSEND table.
+ * @param selector The patched selector.
+ * @param target The IMP to which the entry forwards.
+ *
+ * @return Returns the entry IMP.
+ */
+static IMP patch_imp_configureEntry (void *trampoline, SEL selector, IMP target) {
+    TrampolineTable &table = blockimp_table(PATCH_IMP_MSGSEND);
+    *table.config_entry(trampoline, 0) = NULL;
+    *table.config_entry(trampoline, 1) = (void *) 1; /* Disabled */
+    *table.config_entry(trampoline, 2) = (void *) target;
+    *table.config_entry(trampoline, 3) = selector;
     
-    /* Return the function pointer. */
-    return (IMP) tramp->trampoline;
+    return (IMP) trampoline;
 }
 
-#if UNUSED
+/**
+ * Create a new PLPatchIMP block IMP trampoline.
+ *
+ * @return Returns the new trampoline IMP, or NULL if @a block is not supported on the current architecture (see
+ * patch_imp_isSupported()), or a trampoline could not be allocated.
+ */
+static IMP patch_imp_implementationWithBlock (id block, SEL selector, IMP origIMP) {
+    /* Allocate the appropriate trampoline type. */
+    patch_imp_type type = patch_imp_getType(block);
+    if (!patch_imp_isSupported(block, type))
+        return NULL;
+    
+    void *trampoline = blockimp_cache(type).alloc();
+    if (trampoline == NULL)
+        return NULL;
+    
+    return patch_imp_configure(blockimp_table(type), trampoline, block, selector, origIMP);
+}
 
 /**
  * Return the backing block for an IMP trampoline.
  */
 static void *patch_imp_getBlock (IMP anImp) {
     /* Fetch the config data and return the block reference. */
-    void **config = pl_trampoline_data_ptr(anImp);
+    void **config = blockimp_table(PATCH_IMP_MSGSEND).config_ptr((void *) anImp);
     return config[0];
 }
 
-#endif
+/**
+ * Atomically replace the original IMP to which a PLPatchIMP block IMP trampoline forwards. The store is
+ * performed with release semantics; a concurrent dispatch through @a anImp will observe either the previous or the
+ * new IMP, and will observe the fully configured target of @a origIMP.
+ *
+ * @param anImp A configured block IMP trampoline.
+ * @param origIMP The new original IMP.
+ */
+static void patch_imp_setOrigIMP (IMP anImp, IMP origIMP) {
+    /* All trampoline tables share a configuration layout */
+    void **entry = blockimp_table(PATCH_IMP_MSGSEND).config_entry((void *) anImp, 2);
+    __atomic_store_n(entry, (void *) origIMP, __ATOMIC_RELEASE);
+}
+
+/**
+ * Atomically enable or disable a PLPatchIMP block IMP trampoline. A disabled trampoline tail-calls its original IMP
+ * directly, without calling its block.
+ *
+ * @param anImp A configured block IMP trampoline.
+ * @param enabled true if the trampoline's block should be called, false otherwise.
+ */
+static void patch_imp_setEnabled (IMP anImp, bool enabled) {
+    /* The trampoline dispatchers test for a non-NULL 'disabled' flag */
+    void **entry = blockimp_table(PATCH_IMP_MSGSEND).config_entry((void *) anImp, 1);
+    __atomic_store_n(entry, enabled ? NULL : (void *) 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * Return the type of the trampoline table from which @a anImp was allocated.
+ *
+ * @param anImp A block IMP trampoline.
+ */
+static patch_imp_type patch_imp_getTableType (IMP anImp) {
+    /* Types without a dedicated table share the PATCH_IMP_MSGSEND table, which is checked first */
+    for (size_t type = 0; type < PATCH_IMP_TYPE_COUNT; type++) {
+        if (blockimp_table((patch_imp_type) type).contains((void *) anImp))
+            return (patch_imp_type) type;
+    }
+    
+    PMFatal("Trampoline %p was not allocated from any block IMP trampoline table", anImp);
+}
 
 /**
  * Deallocate the IMP trampoline.
  */
 static BOOL patch_imp_removeBlock (IMP anImp) {
     /* Fetch the config data */
-    void **config = (void **) pl_trampoline_data_ptr((void *) anImp);
-    auto bl = (struct Block_layout *) config[0];
-    auto tramp = (pl_trampoline *) config[1];
+    void **config = blockimp_table(PATCH_IMP_MSGSEND).config_ptr((void *) anImp);
     
-    /* Drop the trampoline allocation */
-    if (bl->flags & BLOCK_USE_STRET) {
-        pl_trampoline_free(&blockimp_lock, &STRET_TABLE, tramp);
-    } else {
-        pl_trampoline_free(&blockimp_lock, &blockimp_table, tramp);
-    }
+    /* Drop the trampoline allocation. The owning table is found by address; deriving it from the block's signature
+     * would be comparatively expensive. */
+    blockimp_cache(patch_imp_getTableType(anImp)).free((void *) anImp);
     
     /* Release the block */
     Block_release(config[0]);
@@ -150,30 +453,259 @@ static BOOL patch_imp_removeBlock (IMP anImp) {
 }
 
 
+#if OBSERVE_TABLE_SUPPORTED
+
 /**
- * @internal
- * Concrete internal implementation of PLPatchMaster. This is implemented seperately to allow us to hide
- * the PLPatchMaster instance variables when targeting Objective-C runtimes (i.e. Mac i386).
+ * Return the observe-only trampoline table for objc_msgSend() dispatch, or for objc_msgSend_stret() dispatch if
+ * @a stret is true. The tables are never deallocated.
  */
-@implementation PLPatchMasterImpl
+static TrampolineTable &observe_table (bool stret) {
+    static TrampolineTable *table = new TrampolineTable(&pl_observe_table_page_config);
+#if STRET_TABLE_REQUIRED
+    static TrampolineTable *stret_table = new TrampolineTable(&pl_observe_table_stret_page_config);
+    if (stret)
+        return *stret_table;
+#endif /* STRET_TABLE_REQUIRED */
+    
+    return *table;
+}
 
-/* Handle dyld image load notifications. These *should* be dispatched after the Objective-C callbacks have been
- * dispatched, but there's no gaurantee. It's possible, though unlikely, that this could break in a future release of Mac OS X. */
-static void dyld_image_add_cb (const struct mach_header *mh, intptr_t vmaddr_slide) {
-    auto *userInfo = [NSMutableDictionary dictionary];
-    [userInfo setObject: [NSValue valueWithPointer: mh] forKey: PLPatchMasterMachHeaderKey];
+#endif /* OBSERVE_TABLE_SUPPORTED */
+
+/**
+ * Return true if messages to @a method must be dispatched via objc_msgSend_stret().
+ */
+static bool observe_imp_requiresStret (Method method) {
+#if STRET_TABLE_REQUIRED
+    char type[256];
+    method_getReturnType(method, type, sizeof(type));
+    if (type[0] != _C_STRUCT_B)
+        return false;
     
-    [[NSNotificationCenter defaultCenter] postNotificationName: PLPatchMasterImageDidLoadNotification object: nil userInfo: userInfo];
+    /* Structures larger than 16 bytes are returned in memory. This does not account for smaller structures that
+     * are returned in memory due to their member types (eg, long double), which are not supported. */
+    NSUInteger size;
+    NSGetSizeAndAlignment(type, &size, NULL);
+    return size > 16;
+#else
+    return false;
+#endif
 }
 
-+ (void) initialize {
-    if (([self class] != [PLPatchMasterImpl class]))
-        return;
+/**
+ * Create a new observe-only IMP trampoline. The trampoline calls @a observer, and then tail-calls @a origIMP with
+ * all arguments intact.
+ *
+ * @param stret The value of observe_imp_requiresStret() for the observed method.
+ * @param observer The observer function.
+ * @param context The context argument to be passed to @a observer.
+ * @param origIMP The original method implementation.
+ *
+ * @return Returns the new trampoline IMP, or NULL if a trampoline could not be allocated, or observe-only trampolines
+ * are not supported on the current architecture.
+ */
+static IMP observe_imp_create (bool stret, PLPatchObserver observer, void *context, IMP origIMP) {
+#if OBSERVE_TABLE_SUPPORTED
+    TrampolineTable &table = observe_table(stret);
+    void *trampoline = table.alloc();
+    if (trampoline == NULL)
+        return NULL;
+    
+    *table.config_entry(trampoline, 0) = (void *) observer;
+    *table.config_entry(trampoline, 1) = context;
+    *table.config_entry(trampoline, 2) = (void *) origIMP;
+    *table.config_entry(trampoline, 3) = NULL; /* Reserved */
+    
+    return (IMP) trampoline;
+#else
+    PMLog("Observe-only patches are not supported on this architecture");
+    return NULL;
+#endif
+}
+
+/**
+ * Deallocate an observe-only IMP trampoline.
+ *
+ * @param anImp A trampoline allocated via observe_imp_create().
+ * @param stret The @a stret value passed to observe_imp_create().
+ */
+static void observe_imp_remove (IMP anImp, bool stret) {
+#if OBSERVE_TABLE_SUPPORTED
+    observe_table(stret).free((void *) anImp);
+#endif
+}
+
+#if SYMBOL_TABLE_SUPPORTED
+
+/**
+ * Return the symbol replacement block trampoline table. The table is never deallocated.
+ */
+static TrampolineTable &symbol_table () {
+    static TrampolineTable *table = new TrampolineTable(&pl_symbol_table_page_config);
+    return *table;
+}
+
+#endif /* SYMBOL_TABLE_SUPPORTED */
+
+/**
+ * Return true if @a block may be dispatched via a symbol replacement block trampoline. The block's arguments
+ * (including the block and PLPatchFunction parameters) must all be passed in registers; the trampoline does not
+ * relocate stack-passed arguments. Blocks may not declare aggregate or long double arguments, and may not return
+ * structures in memory on architectures that pass the structure return pointer as the first argument.
+ */
+static bool symbol_imp_isSupported (id block) {
+#if SYMBOL_TABLE_SUPPORTED
+#if STRET_TABLE_REQUIRED
+    /* The structure return pointer would be shifted along with the function arguments */
+    if (patch_imp_requiresStret(block)) {
+        PMLog("Symbol replacement blocks may not return structures in memory on this architecture");
+        return false;
+    }
+#endif /* STRET_TABLE_REQUIRED */
+    
+    const char *signature = patch_imp_getSignature(block);
+    if (signature == NULL) {
+        PMLog("Symbol replacement blocks must be compiled with a block signature");
+        return false;
+    }
+    
+    @autoreleasepool {
+        NSMethodSignature *sig = [NSMethodSignature signatureWithObjCTypes: signature];
+        
+        /* Skip the block and PLPatchFunction parameters */
+        NSUInteger intArgs;
+        NSUInteger vectorArgs;
+        if (!block_countArguments(sig, 2, &intArgs, &vectorArgs)) {
+            PMLog("Symbol replacement blocks may not declare aggregate or long double arguments");
+            return false;
+        }
+        
+        if (intArgs > SYMBOL_TABLE_MAX_INT_ARGS || vectorArgs > SYMBOL_TABLE_MAX_VECTOR_ARGS) {
+            PMLog("Symbol replacement blocks may not declare more than %d integer or %d floating point arguments on this architecture", SYMBOL_TABLE_MAX_INT_ARGS, SYMBOL_TABLE_MAX_VECTOR_ARGS);
+            return false;
+        }
+    }
+    
+    return true;
+#else
+    PMLog("Symbol replacement blocks are not supported on this architecture");
+    return false;
+#endif /* SYMBOL_TABLE_SUPPORTED */
+}
+
+/**
+ * Create a new symbol replacement block trampoline. The trampoline calls @a block with a PLPatchFunction
+ * referencing @a origFunction, followed by all of the function's arguments.
+ *
+ * @param block The replacement block.
+ * @param origFunction The original function.
+ *
+ * @return Returns the new trampoline, or NULL if a trampoline could not be allocated, or @a block is not supported
+ * on the current architecture (see symbol_imp_isSupported()).
+ */
+static void *symbol_imp_create (id block, void *origFunction) {
+    if (!symbol_imp_isSupported(block))
+        return NULL;
+    
+#if SYMBOL_TABLE_SUPPORTED
+    TrampolineTable &table = symbol_table();
+    void *trampoline = table.alloc();
+    if (trampoline == NULL)
+        return NULL;
+    
+    *table.config_entry(trampoline, 0) = Block_copy((__bridge void *)block);
+    *table.config_entry(trampoline, 1) = origFunction;
+    
+    return trampoline;
+#else
+    return NULL;
+#endif
+}
+
+/**
+ * Resolve the address of @a symbol as exported by @a library, or by any loaded image if @a library is empty.
+ *
+ * @param symbol The symbol name, including any leading underscore.
+ * @param library The install name of the library exporting @a symbol, or an empty string.
+ *
+ * @return Returns the symbol address, or NULL if @a library is not loaded or does not export @a symbol.
+ */
+static void *symbol_resolve (NSString *symbol, NSString *library) {
+    /* dlsym() expects the C-level symbol name */
+    const char *name = symbol.UTF8String;
+    if (name[0] == '_')
+        name++;
+
+    if (library.length == 0)
+        return dlsym(RTLD_DEFAULT, name);
+
+    void *handle = dlopen(library.UTF8String, RTLD_LAZY | RTLD_NOLOAD);
+    if (handle == NULL)
+        return NULL;
+
+    void *result = dlsym(handle, name);
+    dlclose(handle);
+    return result;
+}
+
+/**
+ * Return a SymbolName referencing interned copies of @a library and @a symbol.
+ */
+static SymbolName make_symbol_name (NSString *library, NSString *symbol) {
+    pthread_mutex_lock(&symbol_strings_lock);
+    if (symbol_strings == NULL)
+        symbol_strings = new std::unordered_set<std::string>();
+    
+    const char *image = symbol_strings->insert(library.UTF8String).first->c_str();
+    const char *name = symbol_strings->insert(symbol.UTF8String).first->c_str();
+    pthread_mutex_unlock(&symbol_strings_lock);
     
-    /* Register the shared dyld image add function */
-    _dyld_register_func_for_add_image(dyld_image_add_cb);
+    return SymbolName(image, name);
 }
 
+@interface PLPatchMasterImpl ()
+- (void) handleImageLoad: (const struct mach_header *) mh path: (const char *) name;
+- (void) handleImageUnload: (const struct mach_header *) mh;
+@end
+
+/**
+ * @internal
+ *
+ * Forwards image events from the shared ImageEventSource to a PLPatchMasterImpl instance.
+ */
+class PatchMasterImageListener : public ImageEventListener {
+public:
+    /**
+     * Construct a new listener.
+     *
+     * @param impl The target instance. This reference is unretained.
+     */
+    PatchMasterImageListener (PLPatchMasterImpl *impl) : _impl(impl) {}
+
+    virtual void image_added (const void *header, intptr_t slide, const char *path) {
+        @autoreleasepool {
+            [_impl handleImageLoad: (const struct mach_header *) header path: path];
+        }
+    }
+
+    virtual void image_removed (const void *header, intptr_t slide, const char *path) {
+        @autoreleasepool {
+            [_impl handleImageUnload: (const struct mach_header *) header];
+        }
+    }
+
+private:
+    /** The unretained target instance. */
+    PLPatchMasterImpl *_impl;
+};
+
+/**
+ * @internal
+ * Concrete internal implementation of PLPatchMaster. This is implemented seperately to allow us to hide
+ * the PLPatchMaster instance variables when targeting Objective-C runtimes (i.e. Mac i386).
+ */
+@implementation PLPatchMasterImpl
+
 - (instancetype) init {
     if ((self = [super init]) == nil)
         return nil;
@@ -182,77 +714,344 @@ static void dyld_image_add_cb (const struct mach_header *mh, intptr_t vmaddr_sli
     _classPatches = [[NSMutableDictionary dictionary] retain];
     _instancePatches = [[NSMutableDictionary dictionary] retain];
     _restoreBlocks = [[NSMutableArray array] retain];
-    _pendingPatches = [[NSMutableArray array] retain];
+    _pendingPatches = [[NSMutableDictionary dictionary] retain];
+    _pendingSelectorPatches = [[NSMutableArray array] retain];
     _lock = OS_SPINLOCK_INIT;
+    pthread_mutex_init(&_symbolLock, NULL);
+    _symbolPatches = std::make_shared<const PatchTable>();
+    _imageBindStateLock = OS_SPINLOCK_INIT;
+    _queueLock = OS_SPINLOCK_INIT;
+    _imageLoadQueue = dispatch_queue_create("coop.plausible.patchmaster.image-load", DISPATCH_QUEUE_SERIAL);
+    dispatch_queue_set_specific(_imageLoadQueue, &image_load_queue_key, self, NULL);
+    _patchQueue = dispatch_queue_create("coop.plausible.patchmaster.patch", DISPATCH_QUEUE_SERIAL);
     
-    /* Watch for image loads */
-    [[NSNotificationCenter defaultCenter] addObserver: self selector: @selector(handleImageLoad:) name: PLPatchMasterImageDidLoadNotification object: nil];
+    /* Watch for image loads. This must be done last; events may be delivered immediately. */
+    _imageListener = new PatchMasterImageListener(self);
+    ImageEventSource::shared().add_listener(_imageListener);
     
     return self;
 }
 
 - (void) dealloc {
-    [[NSNotificationCenter defaultCenter] removeObserver: self];
+    ImageEventSource::shared().remove_listener(_imageListener);
+    delete _imageListener;
+    
+    /* Wait for any in-flight batch to complete */
+    dispatch_sync(_imageLoadQueue, ^{});
+    dispatch_release(_imageLoadQueue);
+    dispatch_release(_patchQueue);
+    
     [_classPatches release];
     [_instancePatches release];
     [_restoreBlocks release];
     [_pendingPatches release];
+    [_pendingSelectorPatches release];
+    pthread_mutex_destroy(&_symbolLock);
     
     [super dealloc];
 }
 
-// PLPatchMasterImageDidLoadNotification notification handler
-- (void) handleImageLoad: (NSNotification *) notification {
-    /* Apply all dyld symbol rebindings */
-    {
-        auto mh = (const struct mach_header *) [[[notification userInfo] objectForKey: PLPatchMasterMachHeaderKey] pointerValue];
-        const char *name = nullptr;
-        for (uint32_t i = 0; i < _dyld_image_count(); i++) {
-            if (_dyld_get_image_header(i) != mh)
-                continue;
-            name = _dyld_get_image_name(i);
+// Image load event handler
+- (void) handleImageLoad: (const struct mach_header *) mh path: (const char *) name {
+    BOOL batch;
+    BOOL schedule = NO;
+    
+    /* Register the image's rebinding state; any existing state belongs to an image previously mapped at this
+     * address. */
+    OSSpinLockLock(&_imageBindStateLock); {
+        _imageBindStates[mh] = std::make_shared<ImageBindState>();
+    } OSSpinLockUnlock(&_imageBindStateLock);
+    
+    OSSpinLockLock(&_queueLock); {
+        batch = _batchImageLoads;
+        if (batch) {
+            /* Only the first image of a burst needs to schedule processing; the rest join its batch */
+            schedule = _queuedImages.empty();
+            _queuedImages.push_back(LoadedImage { mh, name != nullptr ? name : "" });
         }
         
-        /* Apply any symbol rebindings immediately */
-        if (name == nullptr) {
-            PMLog("Failed to lookup Mach-O image name; skipping patching");
-        } else {
-            OSSpinLockLock(&_lock);
-            perform_dyld_rebinding(_symbolPatches, name, mh);
-            OSSpinLockUnlock(&_lock);
-        }
+        /* A new image has been mapped at this address */
+        _drainUnloadedImages.erase(mh);
+    } OSSpinLockUnlock(&_queueLock);
+    
+    if (!batch) {
+        [self processImageLoads: std::vector<LoadedImage> { LoadedImage { mh, name != nullptr ? name : "" } }];
+        return;
     }
     
-    /* Apply all Objective-C patches */
-    NSArray *blocks;
-    OSSpinLockLock(&_lock); {
-        blocks = [[_pendingPatches copy] autorelease];
-    } OSSpinLockUnlock(&_lock);
+    if (schedule) {
+        dispatch_async(_imageLoadQueue, ^{
+            [self drainImageLoads];
+        });
+    }
+}
+
+/**
+ * @internal
+ *
+ * Process all queued image loads. Must be called on _imageLoadQueue.
+ */
+- (void) drainImageLoads {
+    std::vector<LoadedImage> images;
+    OSSpinLockLock(&_queueLock); {
+        images.swap(_queuedImages);
+    } OSSpinLockUnlock(&_queueLock);
     
-    for (BOOL (^patcher)(void) in blocks) {
-        if (patcher()) {
-            OSSpinLockLock(&_lock); {
-                [_pendingPatches removeObject: patcher];
-            } OSSpinLockUnlock(&_lock);
-        }
+    if (images.empty())
+        return;
+    
+    @autoreleasepool {
+        [self processImageLoads: images];
     }
+    
+    OSSpinLockLock(&_queueLock); {
+        _drainUnloadedImages.clear();
+    } OSSpinLockUnlock(&_queueLock);
 }
 
 /**
- * Patch the class method @a selector of @a className, where @a className may not yet have been loaded,
- * or @a selector may not yet have been registered by a category.
+ * @internal
  *
- * This may be used to register patches that will be automatically applied when the bundle or framework
- * to which they apply is loaded.
+ * Return YES if the image at @a mh was unloaded on _imageLoadQueue while the current batch was being processed.
  *
- * @param className The name of the class to patch. The class may not yet have been loaded.
- * @param selector The selector to patch.
- * @param replacementBlock The new implementation for @a selector. The first parameter must be a pointer to PLPatchIMP; the
- * remainder of the parameters must match the original method.
+ * @param mh The image header.
  */
-- (void) patchFutureClassWithName: (NSString *) className selector: (SEL) selector replacementBlock: (id) replacementBlock {
-    /* Create a patch block */
-    BOOL (^patcher)(void) = ^{
+- (BOOL) isDrainUnloadedImage: (const struct mach_header *) mh {
+    BOOL unloaded;
+    OSSpinLockLock(&_queueLock); {
+        unloaded = _drainUnloadedImages.count(mh) != 0;
+    } OSSpinLockUnlock(&_queueLock);
+    
+    return unloaded;
+}
+
+/**
+ * @internal
+ *
+ * Apply all symbol rebindings and pending Objective-C patches to the newly loaded @a images. The image filter
+ * is fetched once for the entire batch, and pending Objective-C patches are evaluated once for the batch.
+ *
+ * @param images The newly loaded images.
+ */
+- (void) processImageLoads: (const std::vector<LoadedImage> &) images {
+    /* Apply any symbol rebindings immediately. This operates on the current patch table snapshot, and
+     * does not block (or wait on) concurrent patch registration; only a concurrent rebinding of the same
+     * image is waited on. */
+    auto filter = std::atomic_load(&_imageFilter);
+    
+    for (auto &&image : images) {
+        if (image.path.empty()) {
+            PMLog("Failed to lookup Mach-O image name; skipping patching");
+            continue;
+        }
+        
+        if (filter != nullptr && !filter->includes(image.path.c_str()))
+            continue;
+        
+        /* The image filter predicate may have unloaded the image */
+        if ([self isDrainUnloadedImage: image.header])
+            continue;
+        
+        [self rebindImage: image];
+    }
+    
+    /* Apply all Objective-C patches to the images that remain loaded */
+    std::vector<LoadedImage> loaded;
+    std::copy_if(images.begin(), images.end(), std::back_inserter(loaded), [self](const LoadedImage &image) {
+        return ![self isDrainUnloadedImage: image.header];
+    });
+    
+    [self applyPendingPatchesForImages: loaded];
+}
+
+// Image unload event handler
+- (void) handleImageUnload: (const struct mach_header *) mh {
+    /* If batching, the image may still be queued (or in the process of being rebound); it must be
+     * processed before it is unmapped.
+     *
+     * If the image is being unloaded from _imageLoadQueue (e.g. by a patch or image filter callback that calls
+     * dlclose()), waiting on the queue would deadlock. The image is instead dropped from the queue, and recorded
+     * so that the batch currently being processed will skip it. */
+    BOOL batch;
+    BOOL draining = dispatch_get_specific(&image_load_queue_key) == self;
+    OSSpinLockLock(&_queueLock); {
+        batch = _batchImageLoads || !_queuedImages.empty();
+        
+        if (draining) {
+            _queuedImages.erase(std::remove_if(_queuedImages.begin(), _queuedImages.end(), [mh](const LoadedImage &image) {
+                return image.header == mh;
+            }), _queuedImages.end());
+            _drainUnloadedImages.insert(mh);
+        }
+    } OSSpinLockUnlock(&_queueLock);
+    
+    if (batch && !draining)
+        [self flushImageLoads];
+    
+    /* Drop the image's rebinding state; an image later loaded at the same address must be rebound in full. */
+    std::shared_ptr<ImageBindState> state;
+    OSSpinLockLock(&_imageBindStateLock); {
+        auto entry = _imageBindStates.find(mh);
+        if (entry != _imageBindStates.end()) {
+            state = entry->second;
+            _imageBindStates.erase(entry);
+        }
+    } OSSpinLockUnlock(&_imageBindStateLock);
+    
+    /* Wait for any in-progress rebinding of the image to complete (the image remains mapped until we return), and
+     * prevent any later rebinding by a caller that has already fetched the state -- eg, a concurrent
+     * rebindLoadedImages pass working from a stale snapshot of the loaded images. */
+    if (state != nullptr) {
+        std::lock_guard<std::mutex> guard(state->lock);
+        state->unloaded = true;
+    }
+    
+    /* Drop all logged bind sites within the image; they must not be restored once the image has been unmapped. */
+    auto patches = std::atomic_load(&_symbolPatches);
+    for (auto &&symbol : *patches) {
+        for (auto &&patch : symbol.second)
+            std::get<3>(patch)->purge(mh);
+    }
+}
+
+/**
+ * @internal
+ *
+ * Return the names of all Objective-C classes defined by the image at @a mh.
+ *
+ * @param mh The image header.
+ * @param path The image path, or NULL if unknown.
+ */
+static std::vector<const char *> objc_class_names (const struct mach_header *mh, const char *path) {
+    std::vector<const char *> names;
+
+#if __OBJC2__
+    /* Read the image's class list directly; depending on the linker and OS release, this may be in any of the
+     * __DATA segments */
+    for (const char *segname : { "__DATA", "__DATA_CONST", "__DATA_DIRTY" }) {
+        size_t size;
+        auto classes = (const Class *) LocalImage::FindSection((const pl_mach_header_t *) mh, segname, "__objc_classlist", &size);
+        if (classes == nullptr)
+            continue;
+        
+        for (size_t i = 0; i < size / sizeof(Class); i++)
+            names.push_back(class_getName(classes[i]));
+    }
+#else
+    /* The legacy runtime does not use __objc_classlist */
+    if (path != nullptr) {
+        unsigned int count;
+        const char **classNames = objc_copyClassNamesForImage(path, &count);
+        if (classNames != NULL) {
+            names.insert(names.end(), classNames, classNames + count);
+            free(classNames);
+        }
+    }
+#endif
+
+    return names;
+}
+
+/**
+ * @internal
+ *
+ * Execute all pending patches that may apply to the newly loaded @a images. Only patches targeting classes
+ * defined by the images, and patches awaiting registration of a selector by a category, are executed.
+ *
+ * @param images The newly loaded images.
+ */
+- (void) applyPendingPatchesForImages: (const std::vector<LoadedImage> &) images {
+    NSMutableArray *blocks = [NSMutableArray array];
+    BOOL classPatchesPending;
+    
+    OSSpinLockLock(&_lock); {
+        classPatchesPending = [_pendingPatches count] > 0;
+        [blocks addObjectsFromArray: _pendingSelectorPatches];
+    } OSSpinLockUnlock(&_lock);
+    
+    /* Collect the patches targeting any class defined by these images */
+    if (classPatchesPending) {
+        for (auto &&image : images) {
+            for (const char *className : objc_class_names(image.header, image.path.empty() ? nullptr : image.path.c_str())) {
+                NSString *key = [NSString stringWithUTF8String: className];
+                
+                OSSpinLockLock(&_lock); {
+                    NSArray *patches = [_pendingPatches objectForKey: key];
+                    if (patches != nil) {
+                        [blocks addObjectsFromArray: patches];
+                        [_pendingPatches removeObjectForKey: key];
+                    }
+                } OSSpinLockUnlock(&_lock);
+            }
+        }
+    }
+    
+    /* Apply the patches; a patch that fails now targets a loaded class, and must be waiting on its selector. */
+    for (BOOL (^patcher)(void) in blocks) {
+        BOOL applied = patcher();
+        
+        OSSpinLockLock(&_lock); {
+            if (applied)
+                [_pendingSelectorPatches removeObjectIdenticalTo: patcher];
+            else if ([_pendingSelectorPatches indexOfObjectIdenticalTo: patcher] == NSNotFound)
+                [_pendingSelectorPatches addObject: patcher];
+        } OSSpinLockUnlock(&_lock);
+    }
+}
+
+/**
+ * @internal
+ *
+ * Register a pending @a patcher block targeting the class named @a className, and attempt to apply it immediately.
+ *
+ * @param patcher A block that will attempt to apply the patch, returning YES on success.
+ * @param className The name of the target class.
+ */
+- (void) registerPendingPatch: (BOOL (^)(void)) patcher className: (NSString *) className {
+    patcher = [[patcher copy] autorelease];
+    
+    /* Register the patch */
+    OSSpinLockLock(&_lock); {
+        NSMutableArray *patches = [_pendingPatches objectForKey: className];
+        if (patches == nil)
+            [_pendingPatches setObject: [NSMutableArray arrayWithObject: patcher] forKey: className];
+        else
+            [patches addObject: patcher];
+    } OSSpinLockUnlock(&_lock);
+    
+    /* Try immediately -- the patch may already have been viable, or the required image may have been concurrently loaded */
+    BOOL applied = patcher();
+    BOOL classLoaded = !applied && NSClassFromString(className) != nil;
+    
+    OSSpinLockLock(&_lock); {
+        NSMutableArray *patches = [_pendingPatches objectForKey: className];
+        if (applied || classLoaded) {
+            [patches removeObjectIdenticalTo: patcher];
+            if ([patches count] == 0)
+                [_pendingPatches removeObjectForKey: className];
+        }
+        
+        /* If the class has already been loaded, we're waiting on a category to register the selector */
+        if (classLoaded)
+            [_pendingSelectorPatches addObject: patcher];
+    } OSSpinLockUnlock(&_lock);
+}
+
+/**
+ * Patch the class method @a selector of @a className, where @a className may not yet have been loaded,
+ * or @a selector may not yet have been registered by a category.
+ *
+ * This may be used to register patches that will be automatically applied when the bundle or framework
+ * to which they apply is loaded.
+ *
+ * @param className The name of the class to patch. The class may not yet have been loaded.
+ * @param selector The selector to patch.
+ * @param replacementBlock The new implementation for @a selector. The first parameter must be a pointer to PLPatchIMP; the
+ * remainder of the parameters must match the original method.
+ */
+- (void) patchFutureClassWithName: (NSString *) className selector: (SEL) selector replacementBlock: (id) replacementBlock {
+    /* Create a patch block */
+    BOOL (^patcher)(void) = ^{
         Class cls = NSClassFromString(className);
         if (!cls)
             return NO;
@@ -264,17 +1063,7 @@ static void dyld_image_add_cb (const struct mach_header *mh, intptr_t vmaddr_sli
         return [self patchClass: cls selector: selector replacementBlock: replacementBlock];
     };
     
-    /* Register the patch */
-    OSSpinLockLock(&_lock); {
-        [_pendingPatches addObject: patcher];
-    } OSSpinLockUnlock(&_lock);
-    
-    /* Try immediately -- the patch may already have been viable, or the required image may have been concurrently loaded */
-    if (patcher()) {
-        OSSpinLockLock(&_lock); {
-            [_pendingPatches removeObject: patcher];
-        } OSSpinLockUnlock(&_lock);
-    }
+    [self registerPendingPatch: patcher className: className];
 }
 
 /**
@@ -303,17 +1092,287 @@ static void dyld_image_add_cb (const struct mach_header *mh, intptr_t vmaddr_sli
         return [self patchInstancesWithClass: cls selector: selector replacementBlock: replacementBlock];
     };
     
-    /* Register the patch */
+    [self registerPendingPatch: patcher className: className];
+}
+
+/**
+ * @internal
+ *
+ * Record a newly applied method patch, registering a restore block that may be used to reverse the patch. The
+ * caller must hold _lock.
+ *
+ * @param cls The patched class.
+ * @param selector The patched selector.
+ * @param instanceMethod YES if an instance method was patched, NO if a class method was patched.
+ * @param oldIMP The IMP that was replaced.
+ * @param newIMP The block IMP trampoline that was inserted.
+ */
+- (void) recordPatchOfClass: (Class) cls selector: (SEL) selector instanceMethod: (BOOL) instanceMethod oldIMP: (IMP) oldIMP newIMP: (IMP) newIMP {
+    [self recordPatchOfClass: cls selector: selector instanceMethod: instanceMethod oldIMP: oldIMP deallocator: ^{
+        patch_imp_removeBlock(newIMP);
+    }];
+}
+
+/**
+ * @internal
+ *
+ * Record a newly applied method patch, registering a restore block that may be used to reverse the patch. The
+ * caller must hold _lock.
+ *
+ * @param cls The patched class.
+ * @param selector The patched selector.
+ * @param instanceMethod YES if an instance method was patched, NO if a class method was patched.
+ * @param oldIMP The IMP that was replaced.
+ * @param deallocator A block responsible for deallocating the inserted trampoline IMP.
+ */
+- (void) recordPatchOfClass: (Class) cls selector: (SEL) selector instanceMethod: (BOOL) instanceMethod oldIMP: (IMP) oldIMP deallocator: (void (^)(void)) deallocator {
+    NSMutableDictionary *patches = instanceMethod ? _instancePatches : _classPatches;
+    NSString *selectorName = NSStringFromSelector(selector);
+
+    /* If the method has already been patched once, we won't need to restore the IMP */
+    BOOL restoreIMP = YES;
+    NSMutableSet *knownSels = patches[cls];
+    if ([knownSels containsObject: selectorName])
+        restoreIMP = NO;
+    
+    /* Otherwise, record the patch and save a restore block */
+    if (knownSels == nil)
+        patches[(id)cls] = [NSMutableSet setWithObject: selectorName];
+    else
+        [knownSels addObject: selectorName];
+    
+    [_restoreBlocks addObject: [[^{
+        if (restoreIMP) {
+            Method m = instanceMethod ? class_getInstanceMethod(cls, selector) : class_getClassMethod(cls, selector);
+            method_setImplementation(m, oldIMP);
+        }
+        deallocator();
+    } copy] autorelease]];
+}
+
+/**
+ * @internal
+ *
+ * Insert the block IMP trampoline @a newIMP as a hook of @a selector, and record the patch. The caller must hold
+ * _lock.
+ *
+ * The new hook is always the outermost hook of the method's chain. On the first patch of a method, @a entry is
+ * installed as the method's implementation; it is a fixed dispatch trampoline that forwards to the chain's first
+ * hook. Later patches are linked in front of the first hook and published with a single atomic update of the entry;
+ * the method's implementation is not modified, and the chain remains reachable even if another patch (eg, an
+ * observe-only patch) has since replaced the method's implementation.
+ *
+ * Around-style hooks forward to the next hook themselves (via PLPatchIMPFoward), and each hook's block necessarily
+ * executes in its own frame; the entry adds only a tail call.
+ *
+ * @param newIMP A configured block IMP trampoline. Its original IMP will be set by this method.
+ * @param cls The class to patch.
+ * @param selector The selector to patch.
+ * @param instanceMethod YES if the instance method should be patched, NO if the class method should be patched.
+ * @param entry A trampoline allocated from the PATCH_IMP_MSGSEND table, to be used as the dispatch entry if the
+ * method has no chain. If the entry is used, this will be set to NULL; otherwise, the caller is responsible for
+ * freeing the trampoline.
+ */
+- (void) insertHook: (IMP) newIMP class: (Class) cls selector: (SEL) selector instanceMethod: (BOOL) instanceMethod entry: (void **) entry {
+    Class target = instanceMethod ? cls : object_getClass(cls);
+    IMP origIMP;
+    
+    auto chain = _methodChains.find(std::make_pair(target, selector));
+    if (chain != _methodChains.end()) {
+        /* Link in front of the chain's first hook; the new hook is published by a single atomic update of the
+         * chain's entry */
+        origIMP = chain->second.origIMP;
+        
+        const std::vector<IMP> &current = *chain->second.hooks;
+        patch_imp_setOrigIMP(newIMP, current.empty() ? origIMP : current.front());
+        
+        auto hooks = std::make_shared<std::vector<IMP>>();
+        hooks->reserve(current.size() + 1);
+        hooks->push_back(newIMP);
+        hooks->insert(hooks->end(), current.begin(), current.end());
+        chain->second.hooks = hooks;
+        
+        patch_imp_setOrigIMP(chain->second.entry, newIMP);
+    } else {
+        /* Start a new chain, and install its entry as the method's implementation */
+        Method m = class_getInstanceMethod(target, selector);
+        origIMP = method_getImplementation(m);
+        patch_imp_setOrigIMP(newIMP, origIMP);
+        
+        IMP entryIMP = patch_imp_configureEntry(*entry, selector, newIMP);
+        *entry = NULL;
+        
+        if (!class_addMethod(target, selector, entryIMP, method_getTypeEncoding(m))) {
+            /* Method already exists in subclass, we just need to swap the IMP */
+            method_setImplementation(m, entryIMP);
+        }
+        
+        _methodChains.emplace(std::make_pair(target, selector), MethodChain { origIMP, entryIMP, std::make_shared<const std::vector<IMP>>(1, newIMP) });
+    }
+    
+    [self recordPatchOfClass: cls selector: selector instanceMethod: instanceMethod oldIMP: origIMP newIMP: newIMP];
+}
+
+/**
+ * @internal
+ *
+ * Find the method chain hook registered with @a replacementBlock. The caller must hold _lock.
+ *
+ * @param cls The patched class.
+ * @param selector The patched selector.
+ * @param instanceMethod YES if the instance method should be searched, NO if the class method should be searched.
+ * @param replacementBlock The replacement block previously registered for @a selector.
+ * @param[out] chain On success, the method chain containing the hook.
+ *
+ * @return Returns the index of the hook within the method chain, or -1 if @a replacementBlock is not registered in the
+ * method's chain.
+ */
+- (ssize_t) findHookOfClass: (Class) cls selector: (SEL) selector instanceMethod: (BOOL) instanceMethod replacementBlock: (id) replacementBlock chain: (MethodChainTable::iterator *) chain {
+    Class target = instanceMethod ? cls : object_getClass(cls);
+    auto entry = _methodChains.find(std::make_pair(target, selector));
+    if (entry == _methodChains.end())
+        return -1;
+    
+    const std::vector<IMP> &hooks = *entry->second.hooks;
+    auto hook = std::find_if(hooks.begin(), hooks.end(), [replacementBlock](IMP imp) {
+        return patch_imp_getBlock(imp) == (__bridge void *) replacementBlock;
+    });
+    
+    if (hook == hooks.end())
+        return -1;
+    
+    *chain = entry;
+    return hook - hooks.begin();
+}
+
+/**
+ * @internal
+ *
+ * Remove the block patch registered with @a replacementBlock from the method chain of @a selector.
+ *
+ * @param cls The patched class.
+ * @param selector The patched selector.
+ * @param instanceMethod YES if the instance method should be modified, NO if the class method should be modified.
+ * @param replacementBlock The replacement block previously registered for @a selector.
+ *
+ * @return Returns YES on success, or NO if @a replacementBlock is not registered in the method's chain.
+ */
+- (BOOL) removePatchOfClass: (Class) cls selector: (SEL) selector instanceMethod: (BOOL) instanceMethod replacementBlock: (id) replacementBlock {
+    BOOL removed = NO;
+    
     OSSpinLockLock(&_lock); {
-        [_pendingPatches addObject: patcher];
+        MethodChainTable::iterator chain;
+        ssize_t idx = [self findHookOfClass: cls selector: selector instanceMethod: instanceMethod replacementBlock: replacementBlock chain: &chain];
+        
+        if (idx >= 0) {
+            const std::vector<IMP> &hooks = *chain->second.hooks;
+            auto hook = hooks.begin() + idx;
+            
+            /* Unlink the hook with a single atomic store; removal of the first hook updates the chain's entry */
+            IMP prev = (hook == hooks.begin()) ? chain->second.entry : *(hook - 1);
+            IMP next = (hook + 1 == hooks.end()) ? chain->second.origIMP : *(hook + 1);
+            patch_imp_setOrigIMP(prev, next);
+            
+            /* The removed trampoline may still be in use by a concurrent caller, and is never deallocated. The
+             * chain (and its entry) is retained even once empty, as the entry remains the method's implementation. */
+            auto updated = std::make_shared<std::vector<IMP>>(hooks.begin(), hook);
+            updated->insert(updated->end(), hook + 1, hooks.end());
+            chain->second.hooks = updated;
+            
+            removed = YES;
+        }
     } OSSpinLockUnlock(&_lock);
     
-    /* Try immediately -- the patch may already have been viable, or the required image may have been concurrently loaded */
-    if (patcher()) {
-        OSSpinLockLock(&_lock); {
-            [_pendingPatches removeObject: patcher];
-        } OSSpinLockUnlock(&_lock);
-    }
+    return removed;
+}
+
+/**
+ * @internal
+ *
+ * Enable or disable the block patch registered with @a replacementBlock.
+ *
+ * @param enabled YES if the patch should be enabled, NO if it should be disabled.
+ * @param cls The patched class.
+ * @param selector The patched selector.
+ * @param instanceMethod YES if the instance method should be modified, NO if the class method should be modified.
+ * @param replacementBlock The replacement block previously registered for @a selector.
+ *
+ * @return Returns YES on success, or NO if @a replacementBlock is not registered in the method's chain.
+ */
+- (BOOL) setEnabled: (BOOL) enabled forPatchOfClass: (Class) cls selector: (SEL) selector instanceMethod: (BOOL) instanceMethod replacementBlock: (id) replacementBlock {
+    BOOL found = NO;
+    
+    OSSpinLockLock(&_lock); {
+        MethodChainTable::iterator chain;
+        ssize_t idx = [self findHookOfClass: cls selector: selector instanceMethod: instanceMethod replacementBlock: replacementBlock chain: &chain];
+        
+        if (idx >= 0) {
+            patch_imp_setEnabled((*chain->second.hooks)[idx], enabled);
+            found = YES;
+        }
+    } OSSpinLockUnlock(&_lock);
+    
+    return found;
+}
+
+/**
+ * Enable or disable a block patch of the class method @a selector of @a cls. A disabled patch forwards directly to the
+ * next patch (or the original implementation) without calling its replacement block; the method itself is not
+ * modified.
+ *
+ * @param enabled YES if the patch should be enabled, NO if it should be disabled.
+ * @param cls The patched class.
+ * @param selector The patched selector.
+ * @param replacementBlock The replacement block previously passed to patchClass:selector:replacementBlock:.
+ *
+ * @return Returns YES on success, or NO if @a replacementBlock is not registered for @a selector.
+ */
+- (BOOL) setEnabled: (BOOL) enabled forPatchOfClass: (Class) cls selector: (SEL) selector replacementBlock: (id) replacementBlock {
+    return [self setEnabled: enabled forPatchOfClass: cls selector: selector instanceMethod: NO replacementBlock: replacementBlock];
+}
+
+/**
+ * Enable or disable a block patch of the instance method @a selector of @a cls. A disabled patch forwards directly to
+ * the next patch (or the original implementation) without calling its replacement block; the method itself is not
+ * modified.
+ *
+ * @param enabled YES if the patch should be enabled, NO if it should be disabled.
+ * @param cls The patched class.
+ * @param selector The patched selector.
+ * @param replacementBlock The replacement block previously passed to patchInstancesWithClass:selector:replacementBlock:.
+ *
+ * @return Returns YES on success, or NO if @a replacementBlock is not registered for @a selector.
+ */
+- (BOOL) setEnabled: (BOOL) enabled forPatchOfInstancesWithClass: (Class) cls selector: (SEL) selector replacementBlock: (id) replacementBlock {
+    return [self setEnabled: enabled forPatchOfClass: cls selector: selector instanceMethod: YES replacementBlock: replacementBlock];
+}
+
+/**
+ * Remove a block patch of the class method @a selector of @a cls. The other patches applied to @a selector are left
+ * in place.
+ *
+ * @param cls The patched class.
+ * @param selector The patched selector.
+ * @param replacementBlock The replacement block previously passed to patchClass:selector:replacementBlock:.
+ *
+ * @return Returns YES on success, or NO if @a replacementBlock is not registered for @a selector.
+ */
+- (BOOL) removePatchOfClass: (Class) cls selector: (SEL) selector replacementBlock: (id) replacementBlock {
+    return [self removePatchOfClass: cls selector: selector instanceMethod: NO replacementBlock: replacementBlock];
+}
+
+/**
+ * Remove a block patch of the instance method @a selector of @a cls. The other patches applied to @a selector are
+ * left in place.
+ *
+ * @param cls The patched class.
+ * @param selector The patched selector.
+ * @param replacementBlock The replacement block previously passed to patchInstancesWithClass:selector:replacementBlock:.
+ *
+ * @return Returns YES on success, or NO if @a replacementBlock is not registered for @a selector.
+ */
+- (BOOL) removePatchOfInstancesWithClass: (Class) cls selector: (SEL) selector replacementBlock: (id) replacementBlock {
+    return [self removePatchOfClass: cls selector: selector instanceMethod: YES replacementBlock: replacementBlock];
 }
 
 /**
@@ -324,6 +1383,9 @@ static void dyld_image_add_cb (const struct mach_header *mh, intptr_t vmaddr_sli
  * @param replacementBlock The new implementation for @a selector. The first parameter must be a pointer to PLPatchIMP; the
  * remainder of the parameters must match the original method.
  *
+ * If @a selector has already been patched, @a replacementBlock is inserted at the head of the method's chain of
+ * patches; see insertHook:class:selector:instanceMethod:entry:.
+ *
  * @return Returns YES on success, or NO if @a selector is not a defined @a cls method.
  */
 - (BOOL) patchClass: (Class) cls selector: (SEL) selector replacementBlock: (id) replacementBlock {
@@ -332,35 +1394,24 @@ static void dyld_image_add_cb (const struct mach_header *mh, intptr_t vmaddr_sli
         return NO;
     
     /* Insert the new implementation */
-    IMP oldIMP = method_getImplementation(m);
-    IMP newIMP = patch_imp_implementationWithBlock(replacementBlock, selector, oldIMP);
+    IMP newIMP = patch_imp_implementationWithBlock(replacementBlock, selector, method_getImplementation(m));
+    if (newIMP == NULL)
+        return NO;
     
-    if (!class_addMethod(object_getClass(cls), selector, newIMP, method_getTypeEncoding(m))) {
-        /* Method already exists in subclass, we just need to swap the IMP */
-        method_setImplementation(m, newIMP);
+    /* Allocate a chain entry in case this is the method's first patch */
+    void *entry = blockimp_cache(PATCH_IMP_MSGSEND).alloc();
+    if (entry == NULL) {
+        patch_imp_removeBlock(newIMP);
+        return NO;
     }
     
     OSSpinLockLock(&_lock); {
-        /* If the method has already been patched once, we won't need to restore the IMP */
-        BOOL restoreIMP = YES;
-        if (_classPatches[cls][NSStringFromSelector(selector)] != nil)
-            restoreIMP = NO;
-        
-        /* Otherwise, record the patch and save a restore block */
-        if (_classPatches[cls] == nil)
-            _classPatches[(id)cls] = [NSMutableSet setWithObject: NSStringFromSelector(selector)];
-        else
-            [_classPatches[(id)cls] addObject: NSStringFromSelector(selector)];
-        
-        [_restoreBlocks addObject: [[^{
-            if (restoreIMP) {
-                Method m = class_getClassMethod(cls, selector);
-                method_setImplementation(m, oldIMP);
-            }
-            patch_imp_removeBlock(newIMP);
-        } copy] autorelease]];
+        [self insertHook: newIMP class: cls selector: selector instanceMethod: NO entry: &entry];
     } OSSpinLockUnlock(&_lock);
     
+    if (entry != NULL)
+        blockimp_cache(PATCH_IMP_MSGSEND).free(entry);
+    
     return YES;
 }
 
@@ -372,6 +1423,9 @@ static void dyld_image_add_cb (const struct mach_header *mh, intptr_t vmaddr_sli
  * @param replacementBlock The new implementation for @a selector. The first parameter must be a pointer to PLPatchIMP; the
  * remainder of the parameters must match the original method.
  *
+ * If @a selector has already been patched, @a replacementBlock is inserted at the head of the method's chain of
+ * patches; see insertHook:class:selector:instanceMethod:entry:.
+ *
  * @return Returns YES on success, or NO if @a selector is not a defined @a cls instance method.
  */
 - (BOOL) patchInstancesWithClass: (Class) cls selector: (SEL) selector replacementBlock: (id) replacementBlock {
@@ -381,35 +1435,23 @@ static void dyld_image_add_cb (const struct mach_header *mh, intptr_t vmaddr_sli
             return NO;
         
         /* Insert the new implementation */
-        IMP oldIMP = method_getImplementation(m);
-        IMP newIMP = patch_imp_implementationWithBlock(replacementBlock, selector, oldIMP);
+        IMP newIMP = patch_imp_implementationWithBlock(replacementBlock, selector, method_getImplementation(m));
+        if (newIMP == NULL)
+            return NO;
         
-        if (!class_addMethod(cls, selector, newIMP, method_getTypeEncoding(m))) {
-            /* Method already exists in subclass, we just need to swap the IMP */
-            method_setImplementation(m, newIMP);
+        /* Allocate a chain entry in case this is the method's first patch */
+        void *entry = blockimp_cache(PATCH_IMP_MSGSEND).alloc();
+        if (entry == NULL) {
+            patch_imp_removeBlock(newIMP);
+            return NO;
         }
         
         OSSpinLockLock(&_lock); {
-            /* If the method has already been patched once, we won't need to restore the IMP */
-            BOOL restoreIMP = YES;
-            NSMutableSet *knownSels = _instancePatches[cls];
-            if ([knownSels containsObject: NSStringFromSelector(selector)])
-                restoreIMP = NO;
-            
-            /* Otherwise, record the patch and save a restore block */
-            if (_instancePatches[cls] == nil)
-                _instancePatches[(id)cls] = [NSMutableSet setWithObject: NSStringFromSelector(selector)];
-            else
-                [_instancePatches[(id)cls] addObject: NSStringFromSelector(selector)];
-            
-            [_restoreBlocks addObject: [[^{
-                if (restoreIMP) {
-                    Method m = class_getInstanceMethod(cls, selector);
-                    method_setImplementation(m, oldIMP);
-                }
-                patch_imp_removeBlock(newIMP);
-            } copy] autorelease]];
+            [self insertHook: newIMP class: cls selector: selector instanceMethod: YES entry: &entry];
         } OSSpinLockUnlock(&_lock);
+        
+        if (entry != NULL)
+            blockimp_cache(PATCH_IMP_MSGSEND).free(entry);
     }
     
     return YES;
@@ -418,44 +1460,331 @@ static void dyld_image_add_cb (const struct mach_header *mh, intptr_t vmaddr_sli
 /**
  * @internal
  *
- * Perform dyld-compatible symbol rebinding of the given image.
+ * Insert an observe-only trampoline for @a selector of @a cls.
  *
- * @param patches The table of patches; if locking is required, locks must be held by the caller.
- * @param image_name The name of the image being rebound.
- * @param mh The in-memory base address of the target image.
+ * @param cls The class to patch.
+ * @param selector The selector to patch.
+ * @param instanceMethod YES if the instance method should be patched, NO if the class method should be patched.
+ * @param observer The observer function.
+ * @param context The context argument to be passed to @a observer.
+ *
+ * @return Returns YES on success, or NO if the method is not defined, or the observer could not be inserted.
  */
-static void perform_dyld_rebinding (const PatchTable &patches, const char *image_name, const struct mach_header *mh) {
-    /* Analyze the image */
-    auto image = LocalImage::Analyze(image_name, (const pl_mach_header_t *) mh);
+- (BOOL) observeClass: (Class) cls selector: (SEL) selector instanceMethod: (BOOL) instanceMethod observer: (PLPatchObserver) observer context: (void *) context {
+    Method m = instanceMethod ? class_getInstanceMethod(cls, selector) : class_getClassMethod(cls, selector);
+    if (m == NULL)
+        return NO;
     
-    /* Rebind all symbols */
-    image.rebind_symbols([&patches](const bind_opstream::symbol_proc &sp) {
-        // TODO: We need to evaluate when/how addend is used.
-        if (sp.addend() != 0) {
-            // PMDebug("Skipping unsupported symbol binding for %s:%s with non-zero addend %" PRId64, name.image().c_str(), name.symbol().c_str(), addend);
-            return;
-        }
-        
-        /* Check whether there are /any/ patches for this symbol */
-        if (patches.count(sp.name().symbol()) == 0)
+    /* Insert the new implementation */
+    bool stret = observe_imp_requiresStret(m);
+    IMP oldIMP = method_getImplementation(m);
+    IMP newIMP = observe_imp_create(stret, observer, context, oldIMP);
+    if (newIMP == NULL)
+        return NO;
+    
+    if (!class_addMethod(instanceMethod ? cls : object_getClass(cls), selector, newIMP, method_getTypeEncoding(m))) {
+        /* Method already exists in subclass, we just need to swap the IMP */
+        method_setImplementation(m, newIMP);
+    }
+    
+    OSSpinLockLock(&_lock); {
+        [self recordPatchOfClass: cls selector: selector instanceMethod: instanceMethod oldIMP: oldIMP deallocator: ^{
+            observe_imp_remove(newIMP, stret);
+        }];
+    } OSSpinLockUnlock(&_lock);
+    
+    return YES;
+}
+
+/**
+ * Observe the class method @a selector of @a cls. The observer is called with the message receiver and selector,
+ * after which the original implementation is tail-called with all arguments intact.
+ *
+ * @param cls The class to patch.
+ * @param selector The selector to observe.
+ * @param observer The observer function.
+ * @param context The context argument to be passed to @a observer.
+ *
+ * @return Returns YES on success, or NO if @a selector is not a defined @a cls method, or observe-only patches
+ * are not supported on the current architecture.
+ */
+- (BOOL) observeClass: (Class) cls selector: (SEL) selector observer: (PLPatchObserver) observer context: (void *) context {
+    return [self observeClass: cls selector: selector instanceMethod: NO observer: observer context: context];
+}
+
+/**
+ * Observe the instance method @a selector of @a cls. The observer is called with the message receiver and selector,
+ * after which the original implementation is tail-called with all arguments intact.
+ *
+ * @param cls The class to patch.
+ * @param selector The selector to observe.
+ * @param observer The observer function.
+ * @param context The context argument to be passed to @a observer.
+ *
+ * @return Returns YES on success, or NO if @a selector is not a defined @a cls instance method, or observe-only
+ * patches are not supported on the current architecture.
+ */
+- (BOOL) observeInstancesWithClass: (Class) cls selector: (SEL) selector observer: (PLPatchObserver) observer context: (void *) context {
+    return [self observeClass: cls selector: selector instanceMethod: YES observer: observer context: context];
+}
+
+/**
+ * Return an entry point that interposes all calls to @a function via @a preHook and @a postHook.
+ *
+ * @param function The function to be interposed.
+ * @param preHook The hook to be called prior to @a function, or NULL.
+ * @param postHook The hook to be called after @a function returns, or NULL.
+ * @param context The context argument to be passed to @a preHook and @a postHook.
+ *
+ * @return Returns the interposing entry point, or NULL if generic interposition is not supported on the current
+ * architecture.
+ */
+- (void *) interposeFunction: (void *) function preHook: (PLPatchInterposePreHook) preHook postHook: (PLPatchInterposePostHook) postHook context: (void *) context {
+    Interposer interposer(preHook, postHook, context);
+    return interposer.interpose(function);
+}
+
+/**
+ * @internal
+ *
+ * Perform dyld-compatible symbol rebinding of the given image.
+ *
+ * @param patches The table of patches. The table must not be modified concurrently. The caller must hold the
+ * image's ImageBindState lock.
+ * @param applied The bind logs of all patches that have already been applied to the image; these will be
+ * skipped.
+ * @param image_name The name of the image being rebound.
+ * @param mh The in-memory base address of the target image.
+ *
+ * The original value of every bind address overwritten by this pass will be recorded in the bind log of the
+ * corresponding patch.
+ *
+ * @return Returns false if the image's bind sites could not be written, in which case no patches were applied.
+ */
+static bool perform_dyld_rebinding (const PatchTable &patches, const std::unordered_set<std::shared_ptr<BindLog>> &applied, const char *image_name, const struct mach_header *mh) {
+    /* Determine which patches have been filtered from (or already applied to) this image; this is checked prior
+     * to analyzing the image, allowing us to skip excluded images without parsing their load commands. */
+    std::unordered_set<const SymbolPatch *> excluded;
+    size_t patchCount = 0;
+    for (auto &&entry : patches) {
+        for (auto &&patch : entry.second) {
+            patchCount++;
+            
+            auto &filter = std::get<2>(patch);
+            if (applied.count(std::get<3>(patch)) != 0 || (filter != nullptr && !filter->includes(image_name)))
+                excluded.insert(&patch);
+        }
+    }
+    
+    if (excluded.size() == patchCount)
+        return true;
+    
+    /* Analyze the image */
+    auto image = LocalImage::Analyze(image_name, (const pl_mach_header_t *) mh);
+    
+    /* Skip images that can not reference any of the patched symbols; this avoids evaluating the image's bind
+     * opcodes entirely. */
+    auto candidate = std::any_of(patches.begin(), patches.end(), [&image, &excluded](const PatchTable::value_type &entry) {
+        return std::any_of(entry.second.begin(), entry.second.end(), [&image, &excluded](const SymbolPatch &patch) {
+            return excluded.count(&patch) == 0 && image.may_bind(std::get<0>(patch));
+        });
+    });
+    
+    if (!candidate)
+        return true;
+    
+    /* Collect all bind site writes; these are applied as a single batch once the image's bind opcodes have been
+     * evaluated, allowing each bind site page to be made writable exactly once. */
+    struct bind_write {
+        BindLog *log;
+        uintptr_t *target;
+        uintptr_t value;
+    };
+    std::vector<bind_write> writes;
+    
+    image.rebind_symbols([&patches, &excluded, &writes](const bind_opstream::symbol_proc &sp) {
+        // TODO: We need to evaluate when/how addend is used.
+        if (sp.addend() != 0) {
+            // PMDebug("Skipping unsupported symbol binding for %s:%s with non-zero addend %" PRId64, name.image().c_str(), name.symbol().c_str(), addend);
+            return;
+        }
+        
+        /* Check whether there are /any/ patches for this symbol */
+        if (patches.count(sp.name().symbol()) == 0)
             return;
         
         /* Fetch the patches and apply /all/ patches the match; this ensures that patches added later take priority. */
         for (auto &&patch : patches.at(sp.name().symbol())) {
-            /* Skip non-matching patches */
+            /* Skip non-matching and filtered patches */
             if (!std::get<0>(patch).match(sp.name()))
                 continue;
             
-            /* Apply matching patches */
-            auto patchValue = std::get<1>(patch);
-            uintptr_t *target = (uintptr_t *) sp.bind_address();
-            if (*target != patchValue) {
-                *target = patchValue;
-            }
+            if (excluded.count(&patch) != 0)
+                continue;
+            
+            /* Queue matching patches */
+            writes.push_back(bind_write { std::get<3>(patch).get(), (uintptr_t *) sp.bind_address(), std::get<1>(patch) });
         }
         
     });
     
+    if (writes.empty())
+        return true;
+    
+    /* Apply all writes in order; later patches take priority */
+    BindSiteWriter writer;
+    for (auto &&w : writes)
+        writer.add(w.target);
+    
+    if (!writer.begin()) {
+        PMLog("Failed to make bind sites writable in %s; skipping patching", image_name);
+        return false;
+    }
+    
+    for (auto &&w : writes) {
+        /* If the patch has been removed since our snapshot of the patch table was taken, its log will refuse
+         * the write. */
+        w.log->write(mh, w.target, w.value);
+    }
+    
+    return true;
+}
+
+/**
+ * @internal
+ *
+ * Remove all patches in @a table for which @a remove returns true, restoring every bind site they overwrote from
+ * their bind logs. Patches are removed in reverse registration order.
+ *
+ * If a bind site has since been overwritten by a later patch (including one that bound the same value), the site
+ * is left unmodified; the later patch's log is instead updated to restore the removed patch's original value.
+ *
+ * @param table The table of patches. This must be an unpublished copy of the patch table.
+ * @param remove The function used to select the patches to be removed.
+ */
+static void restore_symbol_patches (PatchTable &table, const std::function<bool(const SymbolPatch &patch)> &remove) {
+    for (auto symbol = table.begin(); symbol != table.end();) {
+        auto &patches = symbol->second;
+        
+        for (size_t i = patches.size(); i > 0; i--) {
+            auto &patch = patches[i - 1];
+            if (!remove(patch))
+                continue;
+            
+            auto value = std::get<1>(patch);
+            std::get<3>(patch)->restore(value, [&patches, &patch, value](const void *image, const BindLog::entry &site) {
+                for (auto &&other : patches) {
+                    if (&other != &patch && std::get<3>(other)->splice(image, site.address, value, site.original))
+                        return true;
+                }
+                return false;
+            });
+            
+            patches.erase(patches.begin() + (i - 1));
+        }
+        
+        if (patches.size() == 0)
+            symbol = table.erase(symbol);
+        else
+            symbol++;
+    }
+}
+
+/**
+ * @internal
+ *
+ * Publish a new patch table snapshot, produced by applying @a update to a copy of the current table. The caller
+ * must hold _symbolLock.
+ *
+ * @param update A function that will perform the required modifications to the table copy.
+ */
+- (void) updateSymbolPatches: (const std::function<void(PatchTable &table)> &) update {
+    auto table = std::make_shared<PatchTable>(*std::atomic_load(&_symbolPatches));
+    update(*table);
+    std::atomic_store(&_symbolPatches, std::shared_ptr<const PatchTable>(table));
+}
+
+/**
+ * @internal
+ *
+ * Apply all registered symbol patches that have not yet been applied to @a image.
+ *
+ * The image's rebinding is serialized by its ImageBindState lock, and the patch table snapshot is loaded with the
+ * lock held. A concurrent image load and patch registration may both rebind the image; whichever acquires the lock
+ * second will observe the patches applied by the first, and will only write newer patches, ensuring that bind
+ * sites are always written in patch registration order.
+ *
+ * If the image has since been unloaded, or its load has not yet been observed (in which case our image load handler
+ * will rebind it), the image is skipped.
+ *
+ * @param image The image to rebind.
+ */
+- (void) rebindImage: (const LoadedImage &) image {
+    std::shared_ptr<ImageBindState> state;
+    OSSpinLockLock(&_imageBindStateLock); {
+        auto entry = _imageBindStates.find(image.header);
+        if (entry != _imageBindStates.end())
+            state = entry->second;
+    } OSSpinLockUnlock(&_imageBindStateLock);
+    
+    if (state == nullptr)
+        return;
+    
+    std::lock_guard<std::mutex> guard(state->lock);
+    if (state->unloaded)
+        return;
+    
+    auto patches = std::atomic_load(&_symbolPatches);
+    if (!perform_dyld_rebinding(*patches, state->applied, image.path.c_str(), image.header))
+        return;
+    
+    /* Record all patches in the snapshot as applied; this also drops any patches that have since been removed. */
+    state->applied.clear();
+    for (auto &&symbol : *patches) {
+        for (auto &&patch : symbol.second)
+            state->applied.insert(std::get<3>(patch));
+    }
+}
+
+/**
+ * @internal
+ *
+ * Apply all registered symbol patches to all currently loaded images included by the global image filter. The
+ * caller must hold _symbolLock, and must have published the patches to be applied.
+ *
+ * Images are independent of one another, and are analyzed and rebound concurrently across the global concurrent
+ * queue; this method returns once every image has been processed. Patches that have already been applied to an
+ * image are skipped.
+ */
+- (void) rebindLoadedImages {
+    auto filter = std::atomic_load(&_imageFilter);
+    
+    /* Snapshot the set of loaded images; the dyld image indices are not stable across concurrent image
+     * loads and unloads. Images loaded after this point will be rebound by our image load handler. */
+    std::vector<LoadedImage> images;
+    uint32_t count = _dyld_image_count();
+    images.reserve(count);
+    for (uint32_t i = 0; i < count; i++) {
+        const struct mach_header *mh = _dyld_get_image_header(i);
+        const char *name = _dyld_get_image_name(i);
+        if (mh == NULL || name == NULL)
+            continue;
+        
+        images.push_back(LoadedImage { mh, name });
+    }
+    
+    /* Rebind all images. The filters may be safely shared across threads, and each image's bind site writes are
+     * serialized by its ImageBindState lock; images unloaded since the snapshot was taken are skipped.
+     * dispatch_apply() does not return until all iterations have completed. */
+    LoadedImage *imagesPtr = images.data();
+    const ImageFilter *filterPtr = filter.get();
+    dispatch_apply(images.size(), dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t i) {
+        const LoadedImage &image = imagesPtr[i];
+        if (filterPtr != nullptr && !filterPtr->includes(image.path.c_str()))
+            return;
+        
+        [self rebindImage: image];
+    });
 }
 
 /**
@@ -468,29 +1797,104 @@ static void perform_dyld_rebinding (const PatchTable &patches, const char *image
  * @param replacementAddress The new address to which the symbol will be bound.
  */
 - (void) rebindSymbol: (NSString *) symbol fromImage: (NSString *) library replacementAddress: (uintptr_t) replacementAddress {
+    [self rebindSymbol: symbol fromImage: library replacementAddress: replacementAddress imageFilter: nil];
+}
+
+/**
+ * Perform dyld-compatible symbol rebinding of all references to @a symbol defined by @a library across all current
+ * and future loaded images included by @a imageFilter.
+ *
+ * @param symbol The name of the symbol to patch.
+ * @param library The install name (e.g. '/System/Library/Frameworks/Foundation.framework/Versions/C/Foundation') of
+ * the library responsible for exporting the original symbol.
+ * @param replacementAddress The new address to which the symbol will be bound.
+ * @param imageFilter The filter used to select the images to be rebound, or nil to rebind all images. The filter's
+ * rules are captured at the time of the call.
+ */
+- (void) rebindSymbol: (NSString *) symbol fromImage: (NSString *) library replacementAddress: (uintptr_t) replacementAddress imageFilter: (PLPatchImageFilter *) imageFilter {
+    [self registerSymbolPatch: [self symbolPatchWithSymbol: symbol fromImage: library replacementAddress: replacementAddress imageFilter: imageFilter]];
+}
+
+/**
+ * @internal
+ *
+ * Construct a new symbol patch. The rules of @a imageFilter are captured at the time of the call.
+ *
+ * @param symbol The name of the symbol to patch.
+ * @param library The install name of the library responsible for exporting the original symbol.
+ * @param replacementAddress The new address to which the symbol will be bound.
+ * @param imageFilter The filter used to select the images to be rebound, or nil to rebind all images.
+ */
+- (SymbolPatch) symbolPatchWithSymbol: (NSString *) symbol fromImage: (NSString *) library replacementAddress: (uintptr_t) replacementAddress imageFilter: (PLPatchImageFilter *) imageFilter {
+    return std::make_tuple(make_symbol_name(library, symbol), replacementAddress, imageFilter != nil ? [imageFilter compiledFilter] : nullptr, std::make_shared<BindLog>());
+}
+
+/**
+ * @internal
+ *
+ * Register @a patchEntry for all future loaded images, and apply it to all currently loaded images.
+ *
+ * @param patchEntry The patch to register.
+ */
+- (void) registerSymbolPatch: (const SymbolPatch &) patchEntry {
     using namespace std;
-    std::map<std::string, std::vector<std::tuple<SymbolName, uintptr_t>>> foo;
     
-    auto symbolName = SymbolName(library.UTF8String, symbol.UTF8String);
-    auto patchEntry = make_tuple(symbolName, replacementAddress);
+    auto &symbolName = get<0>(patchEntry);
     
-    /* Add to the standard patch table */
-    OSSpinLockLock(&_lock);
-    if (_symbolPatches.count(symbolName.symbol()) == 0) {
-        _symbolPatches.emplace(make_pair(symbolName.symbol(), vector<tuple<SymbolName, uintptr_t>> { patchEntry }));
-    } else {
-        _symbolPatches.at(symbolName.symbol()).push_back(patchEntry);
-    }
+    /* Publish the updated patch table prior to rebinding existing images. An image loaded concurrently may be
+     * rebound by both our pass over the loaded images and the image load handler; the image's ImageBindState
+     * lock orders the two, and the patch will only be written once, after all earlier patches. */
+    pthread_mutex_lock(&_symbolLock);
+    [self updateSymbolPatches: [&symbolName, &patchEntry](PatchTable &table) {
+        table[symbolName.symbol()].push_back(patchEntry);
+    }];
     
-    /* Mock up a patch table and use it to apply the patch to all existing images */
-    auto patchTable = PatchTable();
-    patchTable.emplace(make_pair(symbolName.symbol(), vector<tuple<SymbolName, uintptr_t>> { patchEntry }));
+    [self rebindLoadedImages];
+    pthread_mutex_unlock(&_symbolLock);
+}
+
+/**
+ * Perform dyld-compatible symbol rebinding of references to @a symbol defined by @a library, restricted to
+ * references made by the images in @a importers. No other images will be analyzed or modified.
+ *
+ * @param symbol The name of the symbol to patch.
+ * @param library The install name (e.g. '/System/Library/Frameworks/Foundation.framework/Versions/C/Foundation') of
+ * the library responsible for exporting the original symbol.
+ * @param replacementAddress The new address to which the symbol will be bound.
+ * @param importers The paths of all images whose references should be rebound. The paths must match the image paths
+ * as reported by dyld. Images in this set that have not yet been loaded will be rebound when loaded.
+ */
+- (void) rebindSymbol: (NSString *) symbol fromImage: (NSString *) library replacementAddress: (uintptr_t) replacementAddress importers: (NSArray *) importers {
+    PLPatchImageFilter *filter = [PLPatchImageFilter filter];
+    for (NSString *path in importers)
+        [filter includeImageAtPath: path];
     
-    for (uint32_t i = 0; i < _dyld_image_count(); i++) {
-        const char *name = _dyld_get_image_name(i);
-        perform_dyld_rebinding(patchTable, name, _dyld_get_image_header(i));
-    }
-    OSSpinLockUnlock(&_lock);
+    /* An empty filter includes all images; an empty importer set must match none. */
+    if ([importers count] == 0)
+        [filter setPredicate: ^(NSString *imagePath) { return NO; }];
+    
+    [self rebindSymbol: symbol fromImage: library replacementAddress: replacementAddress imageFilter: filter];
+}
+
+/**
+ * Perform dyld-compatible symbol rebinding of references to @a symbol defined by @a library, restricted to
+ * references made by images for which @a importerPredicate returns YES. The predicate is evaluated before the
+ * image is analyzed; images it rejects are not analyzed or modified.
+ *
+ * @param symbol The name of the symbol to patch.
+ * @param library The install name (e.g. '/System/Library/Frameworks/Foundation.framework/Versions/C/Foundation') of
+ * the library responsible for exporting the original symbol.
+ * @param replacementAddress The new address to which the symbol will be bound.
+ * @param importerPredicate The predicate used to select importing images. It may be called from any thread, and
+ * must not call back into PLPatchMaster. Its result is cached per image, but it may be evaluated more than once --
+ * including concurrently -- for the same image; it must be thread-safe, and must return the same result for any
+ * given image.
+ */
+- (void) rebindSymbol: (NSString *) symbol fromImage: (NSString *) library replacementAddress: (uintptr_t) replacementAddress importerPredicate: (PLPatchImagePredicate) importerPredicate {
+    PLPatchImageFilter *filter = [PLPatchImageFilter filter];
+    [filter setPredicate: importerPredicate];
+    
+    [self rebindSymbol: symbol fromImage: library replacementAddress: replacementAddress imageFilter: filter];
 }
 
 /**
@@ -506,5 +1910,352 @@ static void perform_dyld_rebinding (const PatchTable &patches, const char *image
     [self rebindSymbol: symbol fromImage: @"" replacementAddress: replacementAddress];
 }
 
+/**
+ * Perform dyld-compatible symbol rebinding of all references to @a symbol defined by @a library across all current
+ * and future loaded images, binding each reference to a trampoline that calls @a replacementBlock.
+ *
+ * @param symbol The name of the symbol to patch.
+ * @param library The install name (e.g. '/System/Library/Frameworks/Foundation.framework/Versions/C/Foundation') of
+ * the library responsible for exporting the original symbol, or an empty string to match any library.
+ * @param replacementBlock The replacement block. The block's first argument is a PLPatchFunction pointer, followed
+ * by all of the original function's arguments.
+ *
+ * @return Returns YES on success, or NO if @a symbol could not be resolved, @a replacementBlock is not supported on
+ * the current architecture (see symbol_imp_isSupported()), or a trampoline could not be allocated.
+ */
+- (BOOL) rebindSymbol: (NSString *) symbol fromImage: (NSString *) library replacementBlock: (id) replacementBlock {
+    void *origFunction = symbol_resolve(symbol, library);
+    if (origFunction == NULL) {
+        PMLog("Could not resolve %s in '%s'", symbol.UTF8String, library.UTF8String);
+        return NO;
+    }
+
+    /* The trampoline and block are never deallocated; a restored bind site may still be in use by another thread */
+    void *trampoline = symbol_imp_create(replacementBlock, origFunction);
+    if (trampoline == NULL)
+        return NO;
+
+    [self rebindSymbol: symbol fromImage: library replacementAddress: (uintptr_t) trampoline];
+    return YES;
+}
+
+/**
+ * Perform dyld-compatible symbol rebinding of all references to @a symbol defined by *any* library across all current
+ * and future loaded images, binding each reference to a trampoline that calls @a replacementBlock.
+ *
+ * @param symbol The name of the symbol to patch.
+ * @param replacementBlock The replacement block. The block's first argument is a PLPatchFunction pointer, followed
+ * by all of the original function's arguments.
+ *
+ * @return Returns YES on success, or NO if @a symbol could not be resolved, @a replacementBlock is not supported on
+ * the current architecture (see symbol_imp_isSupported()), or a trampoline could not be allocated.
+ */
+- (BOOL) rebindSymbol: (NSString *) symbol replacementBlock: (id) replacementBlock {
+    return [self rebindSymbol: symbol fromImage: @"" replacementBlock: replacementBlock];
+}
+
+/**
+ * Remove all rebindings of @a symbol registered for @a library, restoring all bind sites that were overwritten
+ * by the rebindings to their original values. Images loaded in the future will no longer be rebound.
+ *
+ * @param symbol The name of the rebound symbol.
+ * @param library The library install name that was supplied when the symbol was rebound.
+ *
+ * @return Returns YES if any matching rebinding was found, or NO otherwise.
+ */
+- (BOOL) restoreSymbol: (NSString *) symbol fromImage: (NSString *) library {
+    const char *symbolStr = symbol.UTF8String;
+    const char *libraryStr = library.UTF8String;
+    
+    BOOL found = NO;
+    pthread_mutex_lock(&_symbolLock); {
+        [self updateSymbolPatches: [symbolStr, libraryStr, &found](PatchTable &table) {
+            restore_symbol_patches(table, [symbolStr, libraryStr, &found](const SymbolPatch &patch) {
+                auto &name = std::get<0>(patch);
+                if (strcmp(name.symbol(), symbolStr) != 0 || strcmp(name.image(), libraryStr) != 0)
+                    return false;
+                
+                found = YES;
+                return true;
+            });
+        }];
+    } pthread_mutex_unlock(&_symbolLock);
+    
+    return found;
+}
+
+/**
+ * Remove all rebindings of @a symbol that were registered for *any* library via
+ * rebindSymbol:replacementAddress:, restoring all bind sites that were overwritten by the rebindings to their
+ * original values.
+ *
+ * @param symbol The name of the rebound symbol.
+ *
+ * @return Returns YES if any matching rebinding was found, or NO otherwise.
+ */
+- (BOOL) restoreSymbol: (NSString *) symbol {
+    return [self restoreSymbol: symbol fromImage: @""];
+}
+
+/**
+ * Restrict all symbol rebinding -- including rebinding of images loaded in the future -- to the images
+ * included by @a imageFilter. Images that have already been rebound are not modified.
+ *
+ * @param imageFilter The filter used to select the images to be rebound, or nil to rebind all images. The
+ * filter's rules are captured at the time of the call.
+ */
+- (void) setImageFilter: (PLPatchImageFilter *) imageFilter {
+    auto filter = imageFilter != nil ? [imageFilter compiledFilter] : nullptr;
+    
+    pthread_mutex_lock(&_symbolLock); {
+        std::atomic_store(&_imageFilter, filter);
+    } pthread_mutex_unlock(&_symbolLock);
+}
+
+/**
+ * Enable or disable batched processing of image loads.
+ *
+ * When enabled, image load events are queued and processed together on a dedicated serial queue, rather
+ * than synchronously from the dynamic linker's callback. Loading a framework will often load dozens of
+ * dependent images in quick succession; batching allows those images to be rebound using a single patch
+ * table snapshot, and pending Objective-C patches to be evaluated once for the entire burst.
+ *
+ * As patches are applied asynchronously, callers that require patches to be applied to a newly loaded image
+ * before proceeding must call flushImageLoads (e.g. immediately after dlopen() returns).
+ *
+ * @param batchImageLoads YES to enable batching, NO to process image loads synchronously. Disabling batching does
+ * not flush any queued image loads.
+ */
+- (void) setBatchImageLoads: (BOOL) batchImageLoads {
+    OSSpinLockLock(&_queueLock); {
+        _batchImageLoads = batchImageLoads;
+    } OSSpinLockUnlock(&_queueLock);
+}
+
+/**
+ * Process all queued image loads, returning once all patches have been applied to every image loaded prior to
+ * the call. If no image loads are queued, this returns immediately.
+ *
+ * This must not be called from within a patch or image filter callback. A pending patch, or the predicate of the
+ * global image filter, may unload an image. Per-patch image filters are evaluated while the image is being rebound,
+ * and must not unload the image being filtered.
+ */
+- (void) flushImageLoads {
+    dispatch_sync(_imageLoadQueue, ^{
+        [self drainImageLoads];
+    });
+}
+
+/**
+ * Asynchronously perform dyld-compatible symbol rebinding of all references to @a symbol defined by @a library
+ * across all current and future loaded images included by @a imageFilter.
+ *
+ * The rebinding is performed on a background queue; asynchronous operations are executed in the order they
+ * were submitted, but are not ordered with respect to synchronous patch operations.
+ *
+ * @param symbol The name of the symbol to patch.
+ * @param library The install name of the library responsible for exporting the original symbol.
+ * @param replacementAddress The new address to which the symbol will be bound.
+ * @param imageFilter The filter used to select the images to be rebound, or nil to rebind all images. The filter's
+ * rules are captured at the time of the call.
+ *
+ * @return A completion handle for the rebinding.
+ */
+- (PLPatchCompletion *) asyncRebindSymbol: (NSString *) symbol fromImage: (NSString *) library replacementAddress: (uintptr_t) replacementAddress imageFilter: (PLPatchImageFilter *) imageFilter {
+    SymbolPatch patchEntry = [self symbolPatchWithSymbol: symbol fromImage: library replacementAddress: replacementAddress imageFilter: imageFilter];
+    
+    return [[[PLPatchCompletion alloc] initWithQueue: _patchQueue operation: ^{
+        [self registerSymbolPatch: patchEntry];
+        return YES;
+    }] autorelease];
+}
+
+/**
+ * Asynchronously apply all method patches and symbol rebindings registered with @a patchSet as a single
+ * transaction. The patch set must not be modified after it has been submitted.
+ *
+ * @param patchSet The patch set to apply.
+ *
+ * @return A completion handle for the transaction; its result reports whether the patch set was applied.
+ *
+ * @sa applyPatchSet:
+ */
+- (PLPatchCompletion *) asyncApplyPatchSet: (PLPatchSet *) patchSet {
+    return [[[PLPatchCompletion alloc] initWithQueue: _patchQueue operation: ^{
+        return [self applyPatchSet: patchSet];
+    }] autorelease];
+}
+
+/**
+ * Return a completion handle that completes once all previously submitted asynchronous operations have completed,
+ * and all queued image loads have been processed.
+ */
+- (PLPatchCompletion *) allImagesProcessed {
+    return [[[PLPatchCompletion alloc] initWithQueue: _patchQueue operation: ^{
+        [self flushImageLoads];
+        return YES;
+    }] autorelease];
+}
+
+/**
+ * @internal
+ *
+ * Reserve block IMP trampolines of every patch_imp_type in bulk.
+ *
+ * @param[out] trampolines An array of PATCH_IMP_TYPE_COUNT vectors; on return, each will be populated with the
+ * trampolines reserved for the corresponding type. On failure, any trampolines that were reserved are left in
+ * place, and must be freed by the caller.
+ * @param counts An array of PATCH_IMP_TYPE_COUNT trampoline counts.
+ *
+ * @return Returns YES on success, or NO if any of the trampolines could not be allocated.
+ */
+- (BOOL) reserveTrampolines: (std::vector<TrampolineTable::slot> *) trampolines counts: (const size_t *) counts {
+    for (size_t type = 0; type < PATCH_IMP_TYPE_COUNT; type++) {
+        if (counts[type] == 0)
+            continue;
+        
+        trampolines[type] = blockimp_table((patch_imp_type) type).reserve(counts[type]);
+        if (trampolines[type].empty()) {
+            PMLog("Failed to allocate %zu trampolines", counts[type]);
+            return NO;
+        }
+    }
+    
+    return YES;
+}
+
+/**
+ * Apply all method patches and symbol rebindings registered with @a patchSet as a single transaction.
+ *
+ * All method patches are validated prior to modifying any runtime state. The patches are then applied under a
+ * single acquisition of the symbol patch lock, and the symbol rebindings are applied to each loaded image in a
+ * single pass. If any patch can not be applied, all changes made by the patch set are rolled back -- symbol bindings are
+ * restored from the bind logs recorded while rebinding -- and no partial state is left behind.
+ *
+ * @param patchSet The patch set to apply.
+ *
+ * @return Returns YES on success, or NO if any patch in @a patchSet could not be applied.
+ */
+- (BOOL) applyPatchSet: (PLPatchSet *) patchSet {
+    using namespace std;
+
+    NSArray *methodPatches = [patchSet methodPatches];
+    NSArray *symbolPatches = [patchSet symbolPatches];
+
+    /* Validate all method patches before modifying any state. Determining a block's trampoline type requires
+     * parsing its signature, and is done once per entry here; the results are reused below, including while
+     * _lock is held. */
+    vector<patch_imp_type> methodPatchTypes;
+    methodPatchTypes.reserve([methodPatches count]);
+
+    for (PLPatchSetMethodEntry *entry in methodPatches) {
+        Method m;
+        if ([entry isInstanceMethod])
+            m = class_getInstanceMethod([entry cls], [entry selector]);
+        else
+            m = class_getClassMethod([entry cls], [entry selector]);
+
+        if (m == NULL) {
+            PMLog("Rejecting patch set: %s is not a defined method of %s", sel_getName([entry selector]), class_getName([entry cls]));
+            return NO;
+        }
+
+        patch_imp_type type = patch_imp_getType([entry replacementBlock]);
+        if (!patch_imp_isSupported([entry replacementBlock], type)) {
+            PMLog("Rejecting patch set: unsupported replacement block for %s", sel_getName([entry selector]));
+            return NO;
+        }
+
+        methodPatchTypes.push_back(type);
+    }
+
+    /* Merge all symbol rebindings into a single table, allowing us to apply them in one pass over each image */
+    auto patchTable = PatchTable();
+    for (PLPatchSetSymbolEntry *entry in symbolPatches) {
+        auto symbolName = make_symbol_name([entry library], [entry symbol]);
+        patchTable[symbolName.symbol()].push_back(SymbolPatch(symbolName, [entry replacementAddress], nullptr, make_shared<BindLog>()));
+    }
+
+    BOOL failed = NO;
+
+    pthread_mutex_lock(&_symbolLock);
+
+    /* Register the symbol rebindings for future images, and apply them to all existing images */
+    if (patchTable.size() > 0) {
+        [self updateSymbolPatches: [&patchTable](PatchTable &table) {
+            for (auto &&symbol : patchTable) {
+                auto &entries = table[symbol.first];
+                entries.insert(entries.end(), symbol.second.begin(), symbol.second.end());
+            }
+        }];
+
+        [self rebindLoadedImages];
+    }
+
+    /* Reserve all required trampolines in bulk; the trampolines may then be configured without any further
+     * allocation (or locking) while the method patches are applied. */
+    size_t trampolineCount[PATCH_IMP_TYPE_COUNT] = { 0 };
+    for (patch_imp_type type : methodPatchTypes)
+        trampolineCount[type]++;
+
+    /* Any method patch may be the first patch of its method, requiring a chain entry */
+    trampolineCount[PATCH_IMP_MSGSEND] += methodPatchTypes.size();
+
+    vector<TrampolineTable::slot> trampolines[PATCH_IMP_TYPE_COUNT];
+    if (![self reserveTrampolines: trampolines counts: trampolineCount]) {
+        PMLog("Rejecting patch set: failed to reserve trampolines");
+        failed = YES;
+    }
+
+    /* Apply all method patches. The method is resolved again here, as an earlier patch in this set may have
+     * inserted a new method into the target class. Once the trampolines have been reserved, applying a method
+     * patch can not fail. */
+    if (!failed) {
+        OSSpinLockLock(&_lock);
+
+        NSUInteger idx = 0;
+        for (PLPatchSetMethodEntry *entry in methodPatches) {
+            patch_imp_type type = methodPatchTypes[idx++];
+            void *trampoline = trampolines[type].back().trampoline;
+            trampolines[type].pop_back();
+
+            /* The original IMP is set on insertion */
+            IMP newIMP = patch_imp_configure(blockimp_table(type), trampoline, [entry replacementBlock], [entry selector], NULL);
+
+            void *chainEntry = trampolines[PATCH_IMP_MSGSEND].back().trampoline;
+            [self insertHook: newIMP class: [entry cls] selector: [entry selector] instanceMethod: [entry isInstanceMethod] entry: &chainEntry];
+            if (chainEntry == NULL)
+                trampolines[PATCH_IMP_MSGSEND].pop_back();
+        }
+
+        OSSpinLockUnlock(&_lock);
+    }
+
+    /* Release any unused trampoline reservations */
+    for (size_t type = 0; type < PATCH_IMP_TYPE_COUNT; type++) {
+        for (auto &&slot : trampolines[type])
+            blockimp_table((patch_imp_type) type).free(slot.trampoline);
+    }
+
+    if (failed && patchTable.size() > 0) {
+        /* Drop our symbol patch registrations, restoring all overwritten symbol bindings from their bind logs */
+        unordered_set<const BindLog *> logs;
+        for (auto &&symbol : patchTable) {
+            for (auto &&patch : symbol.second)
+                logs.insert(get<3>(patch).get());
+        }
+
+        [self updateSymbolPatches: [&logs](PatchTable &table) {
+            restore_symbol_patches(table, [&logs](const SymbolPatch &patch) {
+                return logs.count(get<3>(patch).get()) != 0;
+            });
+        }];
+    }
+
+    pthread_mutex_unlock(&_symbolLock);
+
+    return !failed;
+}
+
 
 @end
\ No newline at end of file
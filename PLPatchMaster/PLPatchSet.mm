@@ -0,0 +1,182 @@
+/*
+ * Author: Landon Fuller <landonf@plausiblelabs.com>
+ *
+ * Copyright (c) 2013-2015 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "PLPatchSetPrivate.h"
+
+/**
+ * A collection of method patches and symbol rebindings to be applied (or rejected) as a single
+ * transaction via -[PLPatchMaster applyPatchSet:].
+ *
+ * Registering a patch with a patch set has no effect until the set is applied. This class is not
+ * thread-safe; a patch set should be populated from a single thread prior to being applied.
+ */
+@implementation PLPatchSet
+
+- (instancetype) init {
+    if ((self = [super init]) == nil)
+        return nil;
+
+    /* Default state */
+    _methodPatches = [[NSMutableArray array] retain];
+    _symbolPatches = [[NSMutableArray array] retain];
+
+    return self;
+}
+
+- (void) dealloc {
+    [_methodPatches release];
+    [_symbolPatches release];
+    [super dealloc];
+}
+
+/**
+ * Add a patch of the class method @a selector of @a cls.
+ *
+ * @param cls The class to patch.
+ * @param selector The selector to patch.
+ * @param replacementBlock The new implementation for @a selector. The first parameter must be a pointer to PLPatchIMP; the
+ * remainder of the parameters must match the original method.
+ */
+- (void) patchClass: (Class) cls selector: (SEL) selector replacementBlock: (id) replacementBlock {
+    auto entry = [[[PLPatchSetMethodEntry alloc] initWithClass: cls selector: selector replacementBlock: replacementBlock instanceMethod: NO] autorelease];
+    [_methodPatches addObject: entry];
+}
+
+/**
+ * Add a patch of the instance method @a selector of @a cls.
+ *
+ * @param cls The class to patch.
+ * @param selector The selector to patch.
+ * @param replacementBlock The new implementation for @a selector. The first parameter must be a pointer to PLPatchIMP; the
+ * remainder of the parameters must match the original method.
+ */
+- (void) patchInstancesWithClass: (Class) cls selector: (SEL) selector replacementBlock: (id) replacementBlock {
+    auto entry = [[[PLPatchSetMethodEntry alloc] initWithClass: cls selector: selector replacementBlock: replacementBlock instanceMethod: YES] autorelease];
+    [_methodPatches addObject: entry];
+}
+
+/**
+ * Add a dyld-compatible symbol rebinding of all references to @a symbol defined by @a library.
+ *
+ * @param symbol The name of the symbol to patch.
+ * @param library The install name of the library responsible for exporting the original symbol.
+ * @param replacementAddress The new address to which the symbol will be bound.
+ */
+- (void) rebindSymbol: (NSString *) symbol fromImage: (NSString *) library replacementAddress: (uintptr_t) replacementAddress {
+    auto entry = [[[PLPatchSetSymbolEntry alloc] initWithSymbol: symbol library: library replacementAddress: replacementAddress] autorelease];
+    [_symbolPatches addObject: entry];
+}
+
+/**
+ * Add a dyld-compatible symbol rebinding of all references to @a symbol defined by *any* library.
+ *
+ * @param symbol The name of the symbol to patch.
+ * @param replacementAddress The new address to which the symbol will be bound.
+ */
+- (void) rebindSymbol: (NSString *) symbol replacementAddress: (uintptr_t) replacementAddress {
+    [self rebindSymbol: symbol fromImage: @"" replacementAddress: replacementAddress];
+}
+
+/**
+ * Return all registered method patches, as PLPatchSetMethodEntry instances.
+ */
+- (NSArray *) methodPatches {
+    return [[_methodPatches copy] autorelease];
+}
+
+/**
+ * Return all registered symbol rebindings, as PLPatchSetSymbolEntry instances.
+ */
+- (NSArray *) symbolPatches {
+    return [[_symbolPatches copy] autorelease];
+}
+
+@end
+
+@implementation PLPatchSetMethodEntry
+
+- (instancetype) initWithClass: (Class) cls selector: (SEL) selector replacementBlock: (id) replacementBlock instanceMethod: (BOOL) instanceMethod {
+    if ((self = [super init]) == nil)
+        return nil;
+
+    _cls = cls;
+    _selector = selector;
+    _replacementBlock = [replacementBlock copy];
+    _instanceMethod = instanceMethod;
+
+    return self;
+}
+
+- (void) dealloc {
+    [_replacementBlock release];
+    [super dealloc];
+}
+
+/** The class to be patched. */
+- (Class) cls { return _cls; }
+
+/** The selector to be patched. */
+- (SEL) selector { return _selector; }
+
+/** The replacement block. */
+- (id) replacementBlock { return _replacementBlock; }
+
+/** YES if this patch targets an instance method, NO if it targets a class method. */
+- (BOOL) isInstanceMethod { return _instanceMethod; }
+
+@end
+
+@implementation PLPatchSetSymbolEntry
+
+- (instancetype) initWithSymbol: (NSString *) symbol library: (NSString *) library replacementAddress: (uintptr_t) replacementAddress {
+    if ((self = [super init]) == nil)
+        return nil;
+
+    _symbol = [symbol copy];
+    _library = [library copy];
+    _replacementAddress = replacementAddress;
+
+    return self;
+}
+
+- (void) dealloc {
+    [_symbol release];
+    [_library release];
+    [super dealloc];
+}
+
+/** The name of the symbol to patch. */
+- (NSString *) symbol { return _symbol; }
+
+/** The install name of the library exporting the symbol, or an empty string to match any library. */
+- (NSString *) library { return _library; }
+
+/** The new address to which the symbol will be bound. */
+- (uintptr_t) replacementAddress { return _replacementAddress; }
+
+@end
@@ -0,0 +1,76 @@
+/*
+ * Author: Landon Fuller <landonf@plausiblelabs.com>
+ *
+ * Copyright (c) 2013-2015 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#import "PLPatchSet.h"
+
+/**
+ * @internal
+ * A single method patch registered with a PLPatchSet.
+ */
+@interface PLPatchSetMethodEntry : NSObject {
+@private
+    Class _cls;
+    SEL _selector;
+    id _replacementBlock;
+    BOOL _instanceMethod;
+}
+
+- (instancetype) initWithClass: (Class) cls selector: (SEL) selector replacementBlock: (id) replacementBlock instanceMethod: (BOOL) instanceMethod;
+
+- (Class) cls;
+- (SEL) selector;
+- (id) replacementBlock;
+- (BOOL) isInstanceMethod;
+
+@end
+
+/**
+ * @internal
+ * A single symbol rebinding registered with a PLPatchSet.
+ */
+@interface PLPatchSetSymbolEntry : NSObject {
+@private
+    NSString *_symbol;
+    NSString *_library;
+    uintptr_t _replacementAddress;
+}
+
+- (instancetype) initWithSymbol: (NSString *) symbol library: (NSString *) library replacementAddress: (uintptr_t) replacementAddress;
+
+- (NSString *) symbol;
+- (NSString *) library;
+- (uintptr_t) replacementAddress;
+
+@end
+
+@interface PLPatchSet ()
+
+- (NSArray *) methodPatches;
+- (NSArray *) symbolPatches;
+
+@end
@@ -0,0 +1,71 @@
+/*
+ * Author: Landon Fuller <landon@landonf.org>
+ *
+ * Copyright (c) 2015 Landon Fuller <landon@landonf.org>.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A trampoline page template configuration, as emitted by gentramp.sh.
+ *
+ * Each trampoline page is preceded by config_planes writable configuration pages. A trampoline's configuration
+ * entry is split into trampoline_size chunks; chunk N is located at the trampoline's page offset within the
+ * page N + 1 pages before the trampoline page.
+ *
+ * The first word of the configuration page immediately preceding each trampoline page (which falls within the
+ * trampoline page's prefix, and is never used by a configuration entry) holds the template_page address.
+ */
+typedef struct pm_trampoline_config {
+    /** The size of a single trampoline slot, including any alignment padding. */
+    uint32_t trampoline_size;
+
+    /** The page offset at which the trampolines are located. */
+    uint32_t page_offset;
+
+    /** The number of trampolines allocated per page. */
+    uint32_t trampoline_count;
+
+    /** The number of configuration pages preceding each trampoline page. */
+    uint32_t config_planes;
+
+    /** The page size assumed by the trampoline template; configuration pages are located relative to the
+     * trampoline page at multiples of this size. This may be any whole multiple of the runtime page size, in
+     * which case each template page is mapped as a run of system pages. */
+    uint32_t page_size;
+
+    /** The template code page. */
+    void *template_page;
+} pm_trampoline_config;
+
+#ifdef __cplusplus
+}
+#endif
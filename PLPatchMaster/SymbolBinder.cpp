@@ -286,6 +286,54 @@ const std::string &LocalImage::MainExecutablePath () {
     return path;
 }
 
+/**
+ * Find the in-memory address of a section within an in-memory Mach-O image, without performing a full
+ * analysis of the image.
+ *
+ * @param header The image header.
+ * @param segname The name of the segment containing the section.
+ * @param sectname The section name.
+ * @param size On success, will be populated with the section's size in bytes.
+ *
+ * @return Returns the section's in-memory address, or NULL if the section was not found.
+ */
+const void *LocalImage::FindSection (const pl_mach_header_t *header, const char *segname, const char *sectname, size_t *size) {
+    intptr_t vm_slide = 0;
+    const pl_section_t *found = nullptr;
+    
+    const uint8_t *cmd_ptr = (const uint8_t *) header + sizeof(*header);
+    for (uint32_t cmd_idx = 0; cmd_idx < header->ncmds; cmd_idx++) {
+        auto cmd = (const struct load_command *) cmd_ptr;
+        cmd_ptr += cmd->cmdsize;
+        
+        if (cmd->cmd != PL_LC_SEGMENT)
+            continue;
+        
+        auto segment = (const pl_segment_command_t *) cmd;
+        
+        /* Use the actual load address of the __TEXT segment to calculate the dyld slide */
+        if (strcmp(segment->segname, SEG_TEXT) == 0)
+            vm_slide = (uintptr_t) header - (uintptr_t) segment->vmaddr;
+        
+        if (found != nullptr || strncmp(segment->segname, segname, sizeof(segment->segname)) != 0)
+            continue;
+        
+        auto sections = (const pl_section_t *) (segment + 1);
+        for (uint32_t i = 0; i < segment->nsects; i++) {
+            if (strncmp(sections[i].sectname, sectname, sizeof(sections[i].sectname)) == 0) {
+                found = &sections[i];
+                break;
+            }
+        }
+    }
+    
+    if (found == nullptr)
+        return nullptr;
+    
+    *size = (size_t) found->size;
+    return (const void *) (found->addr + vm_slide);
+}
+
 /**
  * Analyze an in-memory Mach-O image.
  *
@@ -302,6 +350,8 @@ LocalImage LocalImage::Analyze (const std::string &path, const pl_mach_header_t
     auto segments = std::make_shared<vector<const pl_segment_command_t *>>();
     auto libraries = std::make_shared<vector<const std::string>>();
     pl_segment_command_t *linkedit = nullptr;
+    const struct symtab_command *symtab = nullptr;
+    const struct dysymtab_command *dysymtab = nullptr;
     
     const uint8_t *cmd_ptr = (const uint8_t *) header + sizeof(*header);
     for (uint32_t cmd_idx = 0; cmd_idx < header->ncmds; cmd_idx++) {
@@ -342,6 +392,33 @@ LocalImage LocalImage::Analyze (const std::string &path, const pl_mach_header_t
                 /* Fetch the library path */
                 const char *name = (const char *) (((const char *) cmd) + dylib_cmd->dylib.name.offset);
                 libraries->push_back(name);
+                break;
+            }
+                
+            case LC_SYMTAB:
+                symtab = (const struct symtab_command *) cmd;
+                break;
+                
+            case LC_DYSYMTAB:
+                dysymtab = (const struct dysymtab_command *) cmd;
+                break;
+        }
+    }
+    
+    /* Determine whether the image may perform any flat namespace lookups. Images linked with a flat namespace
+     * always do; two-level images only do so for undefined symbols marked for dynamic lookup
+     * (e.g., via -undefined dynamic_lookup). */
+    bool flat_lookups = false;
+    if ((header->flags & MH_TWOLEVEL) == 0) {
+        flat_lookups = true;
+    } else if (symtab != nullptr && dysymtab != nullptr && linkedit != nullptr) {
+        uintptr_t linkedit_base = (linkedit->vmaddr + vm_slide) - linkedit->fileoff;
+        auto symbols = (const pl_nlist_t *) (linkedit_base + symtab->symoff);
+        
+        for (uint32_t i = dysymtab->iundefsym; i < dysymtab->iundefsym + dysymtab->nundefsym && i < symtab->nsyms; i++) {
+            if (GET_LIBRARY_ORDINAL(symbols[i].n_desc) == DYNAMIC_LOOKUP_ORDINAL) {
+                flat_lookups = true;
+                break;
             }
         }
     }
@@ -375,7 +452,42 @@ LocalImage LocalImage::Analyze (const std::string &path, const pl_mach_header_t
         }
     }
     
-    return LocalImage(path, header, vm_slide, libraries, segments, bindOpcodes);
+    return LocalImage(path, header, vm_slide, libraries, segments, bindOpcodes, flat_lookups);
+}
+
+/**
+ * Return true if this image links against the library with the given @a install_name via LC_LOAD_DYLIB,
+ * LC_LOAD_WEAK_DYLIB, LC_LOAD_UPWARD_DYLIB, or LC_REEXPORT_DYLIB.
+ *
+ * @param install_name The library install name.
+ */
+bool LocalImage::links_library (const char *install_name) const {
+    for (auto &&library : *_libraries) {
+        if (strcmp(library.c_str(), install_name) == 0)
+            return true;
+    }
+    
+    return false;
+}
+
+/**
+ * Return false if none of this image's symbol binding procedures can reference a symbol matching @a name. This
+ * test does not require evaluation of the bind opcode streams, and may be used to cheaply skip images that can not
+ * be affected by a rebinding.
+ *
+ * @param name The symbol name to test; if the name has an empty image path, the image is assumed to be a
+ * candidate.
+ */
+bool LocalImage::may_bind (const SymbolName &name) const {
+    /* Single-level references may be bound from any library. */
+    if (*name.image() == '\0' || _flat_lookups)
+        return true;
+    
+    /* Symbols may be bound from the image itself, or from the main executable */
+    if (_path == name.image() || MainExecutablePath() == name.image())
+        return true;
+    
+    return links_library(name.image());
 }
 
 /**
@@ -31,6 +31,7 @@
 #include "PMLog.h"
 
 #include <mach-o/loader.h>
+#include <mach-o/nlist.h>
 #include <mach-o/dyld.h>
 
 #include <assert.h>
@@ -284,13 +285,17 @@ private:
         const intptr_t vmaddr_slide,
         std::shared_ptr<std::vector<const std::string>> &libraries,
         std::shared_ptr<std::vector<const pl_segment_command_t *>> &segments,
-        std::shared_ptr<std::vector<const bind_opstream>> &bindings
-    ) : _header(header), _vmaddr_slide(vmaddr_slide), _libraries(libraries), _segments(segments), _bindOpcodes(bindings), _path(path) {}
+        std::shared_ptr<std::vector<const bind_opstream>> &bindings,
+        bool flat_lookups
+    ) : _header(header), _vmaddr_slide(vmaddr_slide), _libraries(libraries), _segments(segments), _bindOpcodes(bindings), _flat_lookups(flat_lookups), _path(path) {}
 
 public:
     static const std::string &MainExecutablePath ();
     static LocalImage Analyze (const std::string &path, const pl_mach_header_t *header);
+    static const void *FindSection (const pl_mach_header_t *header, const char *segname, const char *sectname, size_t *size);
     void rebind_symbols (const std::function<void(const bind_opstream::symbol_proc &)> &bind);
+    bool links_library (const char *install_name) const;
+    bool may_bind (const SymbolName &name) const;
     
     /**
      * Return a borrowed reference to the image's path.
@@ -312,6 +317,12 @@ public:
      */
     std::shared_ptr<std::vector<const pl_segment_command_t *>> segments () const { return _segments; }
     
+    /**
+     * Return true if the image may perform flat namespace symbol lookups, in which case any of its symbol
+     * bindings may be resolved from any library.
+     */
+    bool has_flat_lookups () const { return _flat_lookups; }
+    
 private:
     /** Mach-O image header */
     const pl_mach_header_t *_header;
@@ -327,6 +338,9 @@ private:
     
     /** All symbol binding opcodes. */
     std::shared_ptr<std::vector<const bind_opstream>> _bindOpcodes;
+    
+    /** True if the image uses a flat namespace, or references any symbols via dynamic (flat) lookup. */
+    bool _flat_lookups;
 
     /** Image path */
     const std::string _path;
@@ -0,0 +1,119 @@
+/*
+ * Author: Landon Fuller <landon@landonf.org>
+ *
+ * Copyright (c) 2015 Landon Fuller <landon@landonf.org>.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "TrampolineCache.hpp"
+#include "PMLog.h"
+
+#include <stdlib.h>
+
+namespace patchmaster {
+
+/**
+ * Construct a new cache over the shared trampoline table @a table. The cache must never be destroyed; cached
+ * trampolines remain referenced by the per-thread magazines.
+ *
+ * @param table The shared trampoline table.
+ */
+TrampolineCache::TrampolineCache (TrampolineTable &table) : _table(table) {
+    if (pthread_key_create(&_key, magazine_destructor) != 0)
+        PMFatal("Failed to allocate a trampoline cache thread-local key");
+}
+
+/**
+ * Return the calling thread's magazine, allocating it if necessary.
+ */
+TrampolineCache::magazine *TrampolineCache::thread_magazine () {
+    auto mag = (magazine *) pthread_getspecific(_key);
+    if (mag != nullptr)
+        return mag;
+
+    mag = (magazine *) calloc(1, sizeof(magazine));
+    if (mag == nullptr)
+        return nullptr;
+
+    mag->cache = this;
+    pthread_setspecific(_key, mag);
+    return mag;
+}
+
+/**
+ * Return all trampolines held by an exiting thread's magazine to the shared table.
+ */
+void TrampolineCache::magazine_destructor (void *value) {
+    auto mag = (magazine *) value;
+    auto cache = mag->cache;
+
+    cache->_table.free(mag->trampolines, mag->count);
+
+    ::free(mag);
+}
+
+/**
+ * Allocate a trampoline from the calling thread's magazine, refilling the magazine from the shared table if
+ * it is empty.
+ *
+ * @return Returns the trampoline, or NULL if a trampoline could not be allocated.
+ */
+void *TrampolineCache::alloc () {
+    magazine *mag = thread_magazine();
+    if (mag == nullptr)
+        return _table.alloc();
+
+    if (mag->count == 0) {
+        /* Refill the magazine in a single batch */
+        if (!_table.alloc(BATCH, mag->trampolines))
+            return _table.alloc();
+
+        mag->count = BATCH;
+    }
+
+    return mag->trampolines[--mag->count];
+}
+
+/**
+ * Return @a tramp to the calling thread's magazine. If the magazine is full, half of its trampolines are first
+ * returned to the shared table.
+ *
+ * @param trampoline A trampoline previously allocated from this cache, by any thread.
+ */
+void TrampolineCache::free (void *trampoline) {
+    magazine *mag = thread_magazine();
+    if (mag == nullptr) {
+        _table.free(trampoline);
+        return;
+    }
+
+    if (mag->count == CAPACITY) {
+        mag->count -= BATCH;
+        _table.free(mag->trampolines + mag->count, BATCH);
+    }
+
+    mag->trampolines[mag->count++] = trampoline;
+}
+
+} /* namespace patchmaster */
@@ -0,0 +1,87 @@
+/*
+ * Author: Landon Fuller <landon@landonf.org>
+ *
+ * Copyright (c) 2015 Landon Fuller <landon@landonf.org>.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <pthread.h>
+#include <stddef.h>
+
+#include "TrampolineTable.hpp"
+
+namespace patchmaster {
+
+/**
+ * A per-thread cache of pre-allocated trampolines, layered over a shared TrampolineTable.
+ *
+ * Each thread allocates from (and frees to) its own magazine of trampolines, without acquiring the table's
+ * lock. An empty magazine is refilled from the shared table in a single batch, and a full magazine returns
+ * half of its trampolines to the shared table in a single batch; the table lock is only contended when a
+ * magazine must be refilled or drained.
+ *
+ * A magazine's trampolines are returned to the shared table when its thread exits.
+ */
+class TrampolineCache {
+public:
+    explicit TrampolineCache (TrampolineTable &table);
+
+    TrampolineCache (const TrampolineCache &) = delete;
+    TrampolineCache &operator= (const TrampolineCache &) = delete;
+
+    void *alloc ();
+    void free (void *trampoline);
+
+private:
+    /** The maximum number of trampolines held by a single magazine. */
+    static const size_t CAPACITY = 64;
+
+    /** The number of trampolines fetched from (or returned to) the shared table in a single batch. */
+    static const size_t BATCH = CAPACITY / 2;
+
+    /** A single thread's magazine. */
+    struct magazine {
+        /** The cache that owns this magazine. */
+        TrampolineCache *cache;
+
+        /** Number of valid entries in trampolines. */
+        size_t count;
+
+        /** Cached trampolines. */
+        void *trampolines[CAPACITY];
+    };
+
+    magazine *thread_magazine ();
+    static void magazine_destructor (void *value);
+
+    /** The shared table. */
+    TrampolineTable &_table;
+
+    /** Thread-local storage key for the calling thread's magazine. */
+    pthread_key_t _key;
+};
+
+} /* namespace patchmaster */
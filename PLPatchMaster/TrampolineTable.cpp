@@ -0,0 +1,317 @@
+/*
+ * Author: Landon Fuller <landon@landonf.org>
+ *
+ * Copyright (c) 2015 Landon Fuller <landon@landonf.org>.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "TrampolineTable.hpp"
+#include "PMLog.h"
+
+#ifdef __APPLE__
+#include <mach/mach.h>
+#elif defined(__linux__)
+#include <errno.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace patchmaster {
+
+/**
+ * Construct a new, empty trampoline table.
+ *
+ * @param config The generated trampoline template configuration.
+ */
+TrampolineTable::TrampolineTable (const pm_trampoline_config *config) : _config(config) {}
+
+/**
+ * Return the first chunk of the configuration entry for @a trampoline. The first chunk is always at least
+ * one pointer in size.
+ *
+ * @param trampoline A trampoline allocated from any trampoline table sharing this table's page size.
+ */
+void **TrampolineTable::config_ptr (void *trampoline) const {
+    return (void **) (((uint8_t *) trampoline) - _config->page_size);
+}
+
+/**
+ * Return the pointer-sized word at @a index within the configuration entry for @a trampoline. The entry may be
+ * split across multiple configuration pages; words are numbered consecutively across all chunks.
+ *
+ * @param trampoline A trampoline allocated from this table.
+ * @param index The word index.
+ */
+void **TrampolineTable::config_entry (void *trampoline, size_t index) const {
+    size_t words = _config->trampoline_size / sizeof(void *);
+    size_t plane = index / words;
+    return (void **) (((uint8_t *) trampoline) - ((plane + 1) * _config->page_size)) + (index % words);
+}
+
+#ifdef __APPLE__
+
+/**
+ * Map a region of @a count groups of interleaved configuration and trampoline pages. Configuration pages are
+ * writable; trampoline pages are remapped copies of the template page, and are never writable.
+ *
+ * @param count The number of groups to map.
+ * @param[out] region On success, the base address of the mapped region.
+ *
+ * @return Returns false if the region could not be mapped.
+ */
+bool TrampolineTable::map_region (size_t count, uintptr_t *region) {
+    kern_return_t kt;
+    size_t page_size = _config->page_size;
+    size_t stride = (_config->config_planes + 1) * page_size;
+
+    /* The template may span multiple system pages, but must not share a system page with its configuration */
+    if (page_size % vm_page_size != 0) {
+        PMLog("Trampoline template page size %zu is not a multiple of the system page size %zu", page_size, (size_t) vm_page_size);
+        return false;
+    }
+
+    /* Allocate the configuration and trampoline pages */
+    vm_address_t base;
+    vm_size_t region_size = count * stride;
+    kt = vm_allocate(mach_task_self(), &base, region_size, VM_FLAGS_ANYWHERE);
+    if (kt != KERN_SUCCESS) {
+        PMLog("vm_allocate() failure: %d", kt);
+        return false;
+    }
+
+    /* Remap the trampoline template over the last page of each group */
+    for (size_t i = 0; i < count; i++) {
+        vm_address_t tramp_page = base + (i * stride) + stride - page_size;
+        vm_prot_t cur_prot;
+        vm_prot_t max_prot;
+
+        kt = vm_remap(mach_task_self(), &tramp_page, page_size, 0x0, VM_FLAGS_FIXED | VM_FLAGS_OVERWRITE, mach_task_self(), (vm_address_t) _config->template_page, FALSE, &cur_prot, &max_prot, VM_INHERIT_SHARE);
+        if (kt != KERN_SUCCESS) {
+            PMLog("vm_remap() failure: %d", kt);
+            vm_deallocate(mach_task_self(), base, region_size);
+            return false;
+        }
+    }
+
+    *region = base;
+    return true;
+}
+
+#elif defined(__linux__)
+
+/**
+ * Map a region of @a count groups of interleaved configuration and trampoline pages. Configuration pages are
+ * writable; trampoline pages are read-only, executable mappings of a memfd holding a copy of the template page.
+ * No page is ever mapped both writable and executable.
+ *
+ * @param count The number of groups to map.
+ * @param[out] region On success, the base address of the mapped region.
+ *
+ * @return Returns false if the region could not be mapped.
+ */
+bool TrampolineTable::map_region (size_t count, uintptr_t *region) {
+    size_t page_size = _config->page_size;
+    size_t stride = (_config->config_planes + 1) * page_size;
+
+    /* The template may span multiple system pages, but must not share a system page with its configuration */
+    if (page_size % getpagesize() != 0) {
+        PMLog("Trampoline template page size %zu is not a multiple of the system page size %d", page_size, getpagesize());
+        return false;
+    }
+
+    /* Populate the template file; the template is written via the file descriptor, and is never mapped
+     * writable. */
+    if (_template_fd < 0) {
+        int fd = memfd_create("pm_trampoline_template", MFD_CLOEXEC);
+        if (fd < 0) {
+            PMLog("memfd_create() failure: %d", errno);
+            return false;
+        }
+
+        if (ftruncate(fd, page_size) != 0 || pwrite(fd, _config->template_page, page_size, 0) != (ssize_t) page_size) {
+            PMLog("Failed to write trampoline template: %d", errno);
+            close(fd);
+            return false;
+        }
+
+        _template_fd = fd;
+    }
+
+    /* Map the configuration and trampoline pages */
+    size_t region_size = count * stride;
+    void *base = mmap(NULL, region_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        PMLog("mmap() failure: %d", errno);
+        return false;
+    }
+
+    /* Map the trampoline template over the last page of each group */
+    for (size_t i = 0; i < count; i++) {
+        uint8_t *tramp_page = (uint8_t *) base + (i * stride) + stride - page_size;
+        if (mmap(tramp_page, page_size, PROT_READ | PROT_EXEC, MAP_SHARED | MAP_FIXED, _template_fd, 0) == MAP_FAILED) {
+            PMLog("mmap() failure: %d", errno);
+            munmap(base, region_size);
+            return false;
+        }
+    }
+
+    *region = (uintptr_t) base;
+    return true;
+}
+
+#endif
+
+/**
+ * Map @a count new trampoline pages, and add their trampolines to the free list. The caller must hold _lock.
+ *
+ * All pages are mapped within a single allocation of interleaved configuration and trampoline pages.
+ *
+ * @param count The number of trampoline pages to map.
+ *
+ * @return Returns false if the pages could not be mapped.
+ */
+bool TrampolineTable::map_pages (size_t count) {
+    size_t page_size = _config->page_size;
+    size_t stride = (_config->config_planes + 1) * page_size;
+
+    uintptr_t region;
+    if (!map_region(count, &region))
+        return false;
+
+    _regions.push_back(TrampolineTable::region { region, region + count * stride });
+
+    /* Populate the free list; trampolines are pushed in reverse order, such that allocations are made in
+     * address order. */
+    _free.reserve(_free.size() + count * _config->trampoline_count);
+    for (size_t i = count; i > 0; i--) {
+        uint8_t *tramp_page = (uint8_t *) region + ((i - 1) * stride) + stride - page_size;
+
+        /* Record the template page address in the unused prefix of the preceding configuration page; this is
+         * used by templates that must perform PC-relative addressing relative to the original template page. */
+        *(void **) (tramp_page - page_size) = _config->template_page;
+
+        for (uint32_t t = _config->trampoline_count; t > 0; t--)
+            _free.push_back(tramp_page + _config->page_offset + ((t - 1) * _config->trampoline_size));
+    }
+
+    return true;
+}
+
+/**
+ * Allocate a single trampoline.
+ *
+ * @return Returns the trampoline, or NULL if the allocation failed.
+ */
+void *TrampolineTable::alloc () {
+    void *trampoline;
+    if (!alloc(1, &trampoline))
+        return nullptr;
+
+    return trampoline;
+}
+
+/**
+ * Allocate @a count trampolines, acquiring the table lock once. Any pages required to satisfy the request are
+ * mapped in a single allocation.
+ *
+ * @param count The number of trampolines to allocate.
+ * @param[out] trampolines On success, will be populated with @a count trampolines.
+ *
+ * @return Returns false if the trampolines could not be allocated, in which case no trampolines are allocated.
+ */
+bool TrampolineTable::alloc (size_t count, void **trampolines) {
+    std::lock_guard<std::mutex> guard(_lock);
+
+    if (_free.size() < count) {
+        size_t required = count - _free.size();
+        size_t pages = (required + _config->trampoline_count - 1) / _config->trampoline_count;
+        if (!map_pages(pages))
+            return false;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        trampolines[i] = _free.back();
+        _free.pop_back();
+    }
+
+    return true;
+}
+
+/**
+ * Allocate @a count trampolines and their configuration slots in a single operation. The caller may configure
+ * the returned trampolines without any further locking.
+ *
+ * @param count The number of trampolines to allocate.
+ *
+ * @return Returns the allocated trampolines, or an empty vector if the allocation failed.
+ */
+std::vector<TrampolineTable::slot> TrampolineTable::reserve (size_t count) {
+    std::vector<void *> trampolines(count);
+    if (!alloc(count, trampolines.data()))
+        return std::vector<slot>();
+
+    std::vector<slot> slots;
+    slots.reserve(count);
+    for (void *trampoline : trampolines)
+        slots.push_back(slot { trampoline, config_ptr(trampoline) });
+
+    return slots;
+}
+
+/**
+ * Return @a trampoline to the table.
+ *
+ * @param trampoline A trampoline previously allocated from this table.
+ */
+void TrampolineTable::free (void *trampoline) {
+    free(&trampoline, 1);
+}
+
+/**
+ * Return @a count trampolines to the table, acquiring the table lock once.
+ *
+ * @param trampolines Trampolines previously allocated from this table.
+ * @param count The number of trampolines.
+ */
+void TrampolineTable::free (void *const *trampolines, size_t count) {
+    std::lock_guard<std::mutex> guard(_lock);
+    _free.insert(_free.end(), trampolines, trampolines + count);
+}
+
+/**
+ * Return true if @a trampoline was allocated from this table.
+ *
+ * @param trampoline The trampoline address.
+ */
+bool TrampolineTable::contains (const void *trampoline) const {
+    std::lock_guard<std::mutex> guard(_lock);
+    for (auto &&r : _regions) {
+        if ((uintptr_t) trampoline >= r.start && (uintptr_t) trampoline < r.end)
+            return true;
+    }
+
+    return false;
+}
+
+} /* namespace patchmaster */
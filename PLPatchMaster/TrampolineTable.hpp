@@ -0,0 +1,115 @@
+/*
+ * Author: Landon Fuller <landon@landonf.org>
+ *
+ * Copyright (c) 2015 Landon Fuller <landon@landonf.org>.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <mutex>
+#include <vector>
+
+#include "PMTrampolineConfig.h"
+
+namespace patchmaster {
+
+/**
+ * A table of trampolines, allocated from remapped copies of a generated trampoline template page. On Darwin, the
+ * template page is remapped via vm_remap(); on Linux, a copy of the template is written to a memfd, which is then
+ * mapped read-only and executable. Trampoline pages are never writable.
+ *
+ * Each trampoline page is immediately preceded by one or more writable configuration pages (see
+ * pm_trampoline_config); the trampoline at a given page offset locates its configuration entry at the same
+ * offset within the configuration pages.
+ *
+ * Unlike the PLBlockIMP trampoline table, trampolines may be allocated in bulk; a bulk allocation acquires the
+ * table lock once, and maps all of the pages required to satisfy the request in a single allocation. Trampoline
+ * pages are retained by the table once allocated, and are reused for later allocations.
+ *
+ * This class is thread-safe.
+ */
+class TrampolineTable {
+public:
+    /** A single allocated trampoline and its configuration slot. */
+    struct slot {
+        /** The trampoline's entry point. */
+        void *trampoline;
+
+        /** The first chunk of the trampoline's configuration entry; see config_entry(). */
+        void **config;
+    };
+
+    explicit TrampolineTable (const pm_trampoline_config *config);
+
+    TrampolineTable (const TrampolineTable &) = delete;
+    TrampolineTable &operator= (const TrampolineTable &) = delete;
+
+    void *alloc ();
+    bool alloc (size_t count, void **trampolines);
+    std::vector<slot> reserve (size_t count);
+
+    void free (void *trampoline);
+    void free (void *const *trampolines, size_t count);
+
+    bool contains (const void *trampoline) const;
+
+    void **config_entry (void *trampoline, size_t index) const;
+    void **config_ptr (void *trampoline) const;
+
+private:
+    bool map_region (size_t count, uintptr_t *region);
+    bool map_pages (size_t count);
+
+    /** The trampoline template configuration. */
+    const pm_trampoline_config *_config;
+
+    /** A mapped region of configuration and trampoline pages. */
+    struct region {
+        /** The region's base address. */
+        uintptr_t start;
+
+        /** The address following the region's last page. */
+        uintptr_t end;
+    };
+
+    /** Lock that must be held when accessing _free or _regions. */
+    mutable std::mutex _lock;
+
+    /** All free trampolines. Trampolines are allocated in LIFO order. */
+    std::vector<void *> _free;
+
+    /** All regions mapped by this table. Regions are never unmapped. */
+    std::vector<region> _regions;
+
+#ifdef __linux__
+    /** A memfd containing a copy of the template page, or -1 if not yet created. Must be accessed with _lock held. */
+    int _template_fd = -1;
+#endif
+};
+
+} /* namespace patchmaster */
@@ -0,0 +1,127 @@
+/*
+ * Author: Landon Fuller <landon@landonf.org>
+ *
+ * Copyright (c) 2015 Landon Fuller <landon@landonf.org>.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "BindSiteWriter.hpp"
+#include "PMTest.hpp"
+
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace patchmaster;
+
+/* Return true if /proc/self/maps reports the page at @a page as writable */
+static bool page_is_writable (const void *page) {
+    FILE *maps = fopen("/proc/self/maps", "r");
+    PMTestAssert(maps != NULL, "failed to open /proc/self/maps");
+
+    bool writable = false;
+    unsigned long start, end;
+    char perms[5];
+    char line[PATH_MAX + 128];
+    while (fgets(line, sizeof(line), maps) != NULL) {
+        if (sscanf(line, "%lx-%lx %4s", &start, &end, perms) == 3 && (uintptr_t) page >= start && (uintptr_t) page < end) {
+            writable = perms[1] == 'w';
+            break;
+        }
+    }
+
+    fclose(maps);
+    return writable;
+}
+
+/* A read-only page is made writable while the writer is open, and restored once it is closed */
+static void testReadOnlyPageIsWritable () {
+    size_t page_size = getpagesize();
+    uintptr_t *page = (uintptr_t *) mmap(NULL, page_size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    PMTestAssert(page != MAP_FAILED, "mmap failed");
+
+    {
+        BindSiteWriter writer;
+        writer.add(page);
+        PMTestAssert(writer.begin(), "failed to make the page writable");
+        PMTestAssert(writer.writable(page), "page not reported as writable");
+        PMTestAssert(page_is_writable(page), "page was not made writable");
+
+        BindSiteWriter::store(page, 42);
+        PMTestAssert(*page == 42, "store was not performed");
+    }
+
+    PMTestAssert(!page_is_writable(page), "page protection was not restored");
+    munmap(page, page_size);
+}
+
+/* A page that could not be made writable by the first writer must be reported as such to every later writer that
+ * includes the page, while the first writer remains open. */
+static void testFailureIsReportedToAllWriters () {
+    size_t page_size = getpagesize();
+
+    /* A shared mapping of a read-only file descriptor may never be made writable */
+    int fd = open("/proc/self/exe", O_RDONLY);
+    PMTestAssert(fd >= 0, "open failed");
+    void *page = mmap(NULL, page_size, PROT_READ, MAP_SHARED, fd, 0);
+    PMTestAssert(page != MAP_FAILED, "mmap failed");
+    close(fd);
+
+    uintptr_t *writable_page = (uintptr_t *) mmap(NULL, page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    PMTestAssert(writable_page != MAP_FAILED, "mmap failed");
+
+    BindSiteWriter first;
+    first.add(page);
+    PMTestAssert(!first.begin(), "read-only shared page reported as writable");
+    PMTestAssert(!first.writable(page), "read-only shared page reported as writable");
+
+    BindSiteWriter second;
+    second.add(page);
+    second.add(writable_page);
+    PMTestAssert(!second.begin(), "earlier failure was not reported to the second writer");
+    PMTestAssert(!second.writable(page), "earlier failure was not reported to the second writer");
+    PMTestAssert(second.writable(writable_page), "unrelated page reported as read-only");
+
+    second.end();
+    first.end();
+
+    /* Once all writers are closed, the failure is no longer recorded */
+    BindSiteWriter third;
+    third.add(writable_page);
+    PMTestAssert(third.begin(), "writable page reported as read-only");
+    third.end();
+
+    munmap(page, page_size);
+    munmap(writable_page, page_size);
+}
+
+int main (int argc, char *argv[]) {
+    PMTestRun(testReadOnlyPageIsWritable);
+    PMTestRun(testFailureIsReportedToAllWriters);
+    return 0;
+}
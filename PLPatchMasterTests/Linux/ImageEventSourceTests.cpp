@@ -0,0 +1,109 @@
+/*
+ * Author: Landon Fuller <landon@landonf.org>
+ *
+ * Copyright (c) 2015 Landon Fuller <landon@landonf.org>.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "ImageEventSource.hpp"
+#include "PMTest.hpp"
+
+#include <dlfcn.h>
+#include <string.h>
+
+#include <mutex>
+#include <vector>
+
+using namespace patchmaster;
+
+/**
+ * Records all events delivered for images whose path contains a given substring.
+ */
+class RecordingListener : public ImageEventListener {
+public:
+    explicit RecordingListener (const char *match) : _match(match) {}
+
+    virtual void image_added (const void *header, intptr_t slide, const char *path) {
+        if (path != nullptr && strstr(path, _match) != nullptr) {
+            std::lock_guard<std::mutex> guard(_lock);
+            _added.push_back(header);
+        }
+    }
+
+    virtual void image_removed (const void *header, intptr_t slide, const char *path) {
+        if (path != nullptr && strstr(path, _match) != nullptr) {
+            std::lock_guard<std::mutex> guard(_lock);
+            _removed.push_back(header);
+        }
+    }
+
+    std::vector<const void *> added () { std::lock_guard<std::mutex> guard(_lock); return _added; }
+    std::vector<const void *> removed () { std::lock_guard<std::mutex> guard(_lock); return _removed; }
+
+private:
+    const char *_match;
+    std::mutex _lock;
+    std::vector<const void *> _added;
+    std::vector<const void *> _removed;
+};
+
+static PollingImageEventSource &source () {
+    return static_cast<PollingImageEventSource &>(ImageEventSource::shared());
+}
+
+/* Image loads and unloads are only observed once poll() is called */
+static void testPollObservesLoadAndUnload () {
+    RecordingListener listener("libz.so");
+    ImageEventSource::shared().add_listener(&listener);
+
+    source().poll();
+    PMTestAssert(listener.added().empty(), "libz must not be loaded by the test executable");
+
+    void *handle = dlopen("libz.so.1", RTLD_NOW | RTLD_LOCAL);
+    PMTestAssert(handle != nullptr, "%s", dlerror());
+    PMTestAssert(listener.added().empty(), "events must not be delivered prior to poll()");
+
+    source().poll();
+    PMTestAssert(listener.added().size() == 1, "expected a single load event, got %zu", listener.added().size());
+    PMTestAssert(listener.removed().empty(), "unexpected unload event");
+
+    /* Polling again must not report the image a second time */
+    source().poll();
+    PMTestAssert(listener.added().size() == 1, "image reported more than once");
+
+    dlclose(handle);
+    PMTestAssert(listener.removed().empty(), "events must not be delivered prior to poll()");
+
+    source().poll();
+    PMTestAssert(listener.removed().size() == 1, "expected a single unload event, got %zu", listener.removed().size());
+    PMTestAssert(listener.removed()[0] == listener.added()[0], "unload reported a different image header");
+
+    ImageEventSource::shared().remove_listener(&listener);
+}
+
+int main (int argc, char *argv[]) {
+    PMTestRun(testPollObservesLoadAndUnload);
+    return 0;
+}
@@ -0,0 +1,198 @@
+/*
+ * Author: Landon Fuller <landon@landonf.org>
+ *
+ * Copyright (c) 2015 Landon Fuller <landon@landonf.org>.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "PMTest.hpp"
+#include "Interposer.hpp"
+
+#include <string.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace patchmaster;
+
+/*
+ * Tests for the generic x86-64 interposer trampolines.
+ */
+
+/* Hook call counts, shared by all tests */
+static std::atomic<int> pre_count;
+static std::atomic<int> post_count;
+
+static void reset_counts () {
+    pre_count = 0;
+    post_count = 0;
+}
+
+/* Interposer context used to request argument and result modification */
+struct hook_context {
+    /* Value added to the first integer argument by the pre-hook */
+    uintptr_t gpr_delta;
+
+    /* Value added to the first vector (double) result by the post-hook */
+    double vector_delta;
+
+    /* The first stack-passed argument observed by the pre-hook */
+    long stack_arg;
+};
+
+static void pre_hook (void *context, void *function, PLPatchInterposeArguments *arguments) {
+    auto ctx = (hook_context *) context;
+    pre_count++;
+
+    if (ctx != nullptr) {
+        arguments->gpr[0] += ctx->gpr_delta;
+        memcpy(&ctx->stack_arg, arguments->stack, sizeof(ctx->stack_arg));
+    }
+}
+
+static void post_hook (void *context, void *function, PLPatchInterposeResults *results) {
+    auto ctx = (hook_context *) context;
+    post_count++;
+
+    if (ctx != nullptr) {
+        double value;
+        memcpy(&value, results->vector[0], sizeof(value));
+        value += ctx->vector_delta;
+        memcpy(results->vector[0], &value, sizeof(value));
+    }
+}
+
+/* Consumes all integer and vector argument registers, with the remaining arguments passed on the stack */
+__attribute__((noinline)) static double many_args (long a, long b, long c, long d, long e, long f, long g, long h, double v0, double v1, double v2, double v3, double v4, double v5, double v6, double v7, double v8) {
+    return a + b + c + d + e + f + g + h + v0 + v1 + v2 + v3 + v4 + v5 + v6 + v7 + v8;
+}
+typedef double (*many_args_fn)(long, long, long, long, long, long, long, long, double, double, double, double, double, double, double, double, double);
+
+struct large_struct {
+    long value[3];
+};
+
+__attribute__((noinline)) static large_struct struct_return (long value) {
+    return large_struct { { value, value * 2, value * 3 } };
+}
+typedef large_struct (*struct_return_fn)(long);
+
+/* Argument registers, stack arguments, and return registers must be passed through, and may be modified by the
+ * hooks */
+static void testArgumentsAndResults () {
+    reset_counts();
+
+    hook_context ctx = { 100, 1000.0, 0 };
+    Interposer interposer(pre_hook, post_hook, &ctx);
+    auto fn = (many_args_fn) interposer.interpose((void *) many_args);
+    PMTestAssert(fn != nullptr, "interposition failed");
+
+    double result = fn(1, 2, 3, 4, 5, 6, 7, 8, 1, 2, 3, 4, 5, 6, 7, 8, 9);
+    PMTestAssert(result == 36 + 45 + 100 + 1000, "incorrect result %g", result);
+    PMTestAssert(ctx.stack_arg == 7, "pre-hook observed stack argument %ld", ctx.stack_arg);
+    PMTestAssert(pre_count == 1 && post_count == 1, "hooks called %d/%d times", pre_count.load(), post_count.load());
+}
+
+/* Structure returns via a caller-provided buffer must be preserved */
+static void testStructReturn () {
+    reset_counts();
+
+    Interposer interposer(pre_hook, post_hook, nullptr);
+    auto fn = (struct_return_fn) interposer.interpose((void *) struct_return);
+    PMTestAssert(fn != nullptr, "interposition failed");
+
+    large_struct result = fn(5);
+    PMTestAssert(result.value[0] == 5 && result.value[1] == 10 && result.value[2] == 15, "incorrect result");
+    PMTestAssert(pre_count == 1 && post_count == 1, "hooks called %d/%d times", pre_count.load(), post_count.load());
+}
+
+/* Either hook may be omitted */
+static void testNullHooks () {
+    reset_counts();
+
+    Interposer interposer(nullptr, nullptr, nullptr);
+    auto fn = (struct_return_fn) interposer.interpose((void *) struct_return);
+    PMTestAssert(fn != nullptr, "interposition failed");
+    PMTestAssert(fn(7).value[2] == 21, "incorrect result");
+}
+
+static struct_return_fn nested_inner;
+
+__attribute__((noinline)) static large_struct nested_outer (long value) {
+    large_struct result = nested_inner(value);
+    result.value[0]++;
+    return result;
+}
+
+/* Interposed functions that call other interposed functions must return via the correct shadow stack frames */
+static void testNestedCalls () {
+    reset_counts();
+
+    Interposer interposer(pre_hook, post_hook, nullptr);
+    nested_inner = (struct_return_fn) interposer.interpose((void *) struct_return);
+    auto outer = (struct_return_fn) interposer.interpose((void *) nested_outer);
+    PMTestAssert(nested_inner != nullptr && outer != nullptr, "interposition failed");
+
+    for (long i = 0; i < 1000; i++) {
+        large_struct result = outer(i);
+        PMTestAssert(result.value[0] == i + 1 && result.value[2] == i * 3, "incorrect result");
+    }
+
+    PMTestAssert(pre_count == 2000 && post_count == 2000, "hooks called %d/%d times", pre_count.load(), post_count.load());
+}
+
+/* Each thread must maintain its own shadow stack */
+static void testConcurrentCalls () {
+    reset_counts();
+
+    Interposer interposer(pre_hook, post_hook, nullptr);
+    auto fn = (struct_return_fn) interposer.interpose((void *) struct_return);
+    PMTestAssert(fn != nullptr, "interposition failed");
+
+    std::vector<std::thread> threads;
+    for (long t = 0; t < 8; t++) {
+        threads.emplace_back([fn, t] {
+            for (long i = 0; i < 10000; i++)
+                PMTestAssert(fn(t + i).value[1] == (t + i) * 2, "incorrect result");
+        });
+    }
+
+    for (auto &thread : threads)
+        thread.join();
+
+    PMTestAssert(pre_count == 80000 && post_count == 80000, "hooks called %d/%d times", pre_count.load(), post_count.load());
+}
+
+int main (int argc, char *argv[]) {
+    PMTestAssert(Interposer::supported(), "interposition is not supported");
+
+    PMTestRun(testArgumentsAndResults);
+    PMTestRun(testStructReturn);
+    PMTestRun(testNullHooks);
+    PMTestRun(testNestedCalls);
+    PMTestRun(testConcurrentCalls);
+    return 0;
+}
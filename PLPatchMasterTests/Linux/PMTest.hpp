@@ -0,0 +1,51 @@
+/*
+ * Author: Landon Fuller <landon@landonf.org>
+ *
+ * Copyright (c) 2015 Landon Fuller <landon@landonf.org>.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+ * Minimal assertion support for the Linux test programs. XCTest is not available on Linux; each test program
+ * is a standalone executable that exits non-zero (via abort()) on the first failed assertion.
+ */
+
+#define PMTestAssert(cond, fmt, ...) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: assertion failed: %s: " fmt "\n", __FILE__, __LINE__, #cond, ## __VA_ARGS__); \
+        abort(); \
+    } \
+} while(0)
+
+#define PMTestRun(test) do { \
+    fprintf(stderr, "Test %s started\n", #test); \
+    test(); \
+    fprintf(stderr, "Test %s passed\n", #test); \
+} while(0)
@@ -0,0 +1,82 @@
+/*
+ * Author: Landon Fuller <landon@landonf.org>
+ *
+ * Copyright (c) 2015 Landon Fuller <landon@landonf.org>.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "PMTest.hpp"
+#include "TrampolineTable.hpp"
+#include "PLBlockLayout.h"
+
+extern "C" {
+#include "symbol_x86_64.h"
+}
+
+using namespace patchmaster;
+
+/*
+ * Tests for the x86-64 symbol replacement block trampolines.
+ */
+
+/* The patch state passed to symbol replacement blocks; see PLPatchFunction in PLPatchMaster.h */
+struct PatchFunction {
+    void *origFunction;
+};
+
+/* The largest signature supported by the trampoline: all integer and vector argument registers are used once the
+ * block and PLPatchFunction arguments are inserted. */
+typedef double (*max_args_fn)(long, long, long, long, double, double, double, double, double, double, double, double);
+
+__attribute__((noinline)) static double max_args (long a, long b, long c, long d, double v0, double v1, double v2, double v3, double v4, double v5, double v6, double v7) {
+    return (a * 1000) + (b * 100) + (c * 10) + d + v0 + (v1 * 2) + (v2 * 3) + (v3 * 4) + (v4 * 5) + (v5 * 6) + (v6 * 7) + (v7 * 8);
+}
+
+static double max_args_invoke (Block_layout *block, PatchFunction *patch, long a, long b, long c, long d, double v0, double v1, double v2, double v3, double v4, double v5, double v6, double v7) {
+    PMTestAssert(block->reserved == 0x5EED, "block not passed as the first argument");
+    return ((max_args_fn) patch->origFunction)(a, b, c, d, v0, v1, v2, v3, v4, v5, v6, v7) + 0.5;
+}
+
+/* The trampoline must shift the integer arguments, and pass the vector arguments through unmodified */
+static void testArgumentShift () {
+    TrampolineTable table(&pl_symbol_table_page_config);
+    void *trampoline = table.alloc();
+    PMTestAssert(trampoline != nullptr, "allocation failed");
+
+    Block_layout block = { nullptr, 0, 0x5EED, (void (*)(void *, ...)) max_args_invoke, nullptr };
+    *table.config_entry(trampoline, 0) = &block;
+    *table.config_entry(trampoline, 1) = (void *) max_args;
+
+    double expected = max_args(1, 2, 3, 4, 1, 2, 3, 4, 5, 6, 7, 8) + 0.5;
+    double result = ((max_args_fn) trampoline)(1, 2, 3, 4, 1, 2, 3, 4, 5, 6, 7, 8);
+    PMTestAssert(result == expected, "expected %g, got %g", expected, result);
+
+    table.free(trampoline);
+}
+
+int main (int argc, char *argv[]) {
+    PMTestRun(testArgumentShift);
+    return 0;
+}
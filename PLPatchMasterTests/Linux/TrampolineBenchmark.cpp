@@ -0,0 +1,147 @@
+/*
+ * Author: Landon Fuller <landon@landonf.org>
+ *
+ * Copyright (c) 2015 Landon Fuller <landon@landonf.org>.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "TrampolineTable.hpp"
+#include "PLBlockLayout.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+extern "C" {
+#include "blockimp_x86_64.h"
+#include "blockimp_x86_64_callpop.h"
+#include "blockreg_x86_64.h"
+}
+
+using namespace patchmaster;
+
+/*
+ * Measures the per-dispatch cost of the x86-64 block trampolines, relative to the call/pop trampoline design
+ * they replaced (see blockimp_x86_64_callpop.tramp), and of the register ABI trampolines (see
+ * blockreg_x86_64.tramp) relative to the PLPatchIMP struct ABI.
+ *
+ *   make bench
+ *   build/TrampolineBenchmark [iterations]
+ */
+
+/* The patch state constructed by the block trampoline dispatchers; see PLPatchIMP in PLPatchMaster.h */
+struct PatchIMP {
+    void *self;
+    void *origIMP;
+    void *selector;
+};
+
+/* The register ABI patch state; see PLPatchIMPSlot in PLPatchMaster.h */
+struct PatchIMPSlot {
+    void *origIMP;
+    void *selector;
+};
+
+typedef unsigned long (*imp_t)(void *self, void *sel, unsigned long value);
+
+__attribute__((noinline)) static unsigned long original_imp (void *self, void *sel, unsigned long value) {
+    __asm__ volatile ("");
+    return value;
+}
+
+static unsigned long block_invoke (Block_layout *block, PatchIMP *patch, unsigned long value) {
+    return ((imp_t) patch->origIMP)(patch->self, patch->selector, value) + 1;
+}
+
+static unsigned long register_block_invoke (Block_layout *block, const PatchIMPSlot *slot, void *self, unsigned long value) {
+    return ((imp_t) slot->origIMP)(self, slot->selector, value) + 1;
+}
+
+static Block_layout block = { nullptr, 0, 0, (void (*)(void *, ...)) block_invoke, nullptr };
+static Block_layout register_block = { nullptr, 0, 0, (void (*)(void *, ...)) register_block_invoke, nullptr };
+
+/* Allocate and configure a trampoline from @a table; see blockimp_x86_64.tramp for the configuration layout,
+ * which is shared by all of the block trampolines */
+static imp_t make_trampoline (TrampolineTable &table, Block_layout *block) {
+    void *trampoline = table.alloc();
+    if (trampoline == nullptr) {
+        fprintf(stderr, "Trampoline allocation failed\n");
+        exit(1);
+    }
+
+    *table.config_entry(trampoline, 0) = block;
+    *table.config_entry(trampoline, 1) = nullptr;
+    *table.config_entry(trampoline, 2) = (void *) original_imp;
+    *table.config_entry(trampoline, 3) = nullptr;
+
+    return (imp_t) trampoline;
+}
+
+/* Return the mean cost of a single call to @a imp, in nanoseconds */
+static double measure (imp_t imp, unsigned long iterations) {
+    volatile unsigned long total = 0;
+    timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (unsigned long i = 0; i < iterations; i++)
+        total += imp(nullptr, nullptr, i);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double elapsed = ((end.tv_sec - start.tv_sec) * 1e9) + (end.tv_nsec - start.tv_nsec);
+    return elapsed / iterations;
+}
+
+int main (int argc, char *argv[]) {
+    unsigned long iterations = argc > 1 ? strtoul(argv[1], NULL, 10) : 100000000;
+
+    TrampolineTable callpop_table(&pm_bench_callpop_table_page_config);
+    TrampolineTable jmp_table(&pl_blockimp_patch_table_page_config);
+    TrampolineTable register_table(&pl_blockimp_register_table_page_config);
+
+    imp_t callpop = make_trampoline(callpop_table, &block);
+    imp_t jmp = make_trampoline(jmp_table, &block);
+    imp_t reg = make_trampoline(register_table, &register_block);
+
+    if (callpop(nullptr, nullptr, 41) != 42 || jmp(nullptr, nullptr, 41) != 42 || reg(nullptr, nullptr, 41) != 42) {
+        fprintf(stderr, "Trampoline dispatch returned an incorrect result\n");
+        return 1;
+    }
+
+    /* All times are in nanoseconds per call; 'jmp' and 'register' use the struct and register ABIs respectively */
+    printf("%-12s %-12s %-12s %-12s %-20s %s\n", "direct", "call/pop", "jmp", "register", "jmp vs call/pop", "register vs jmp");
+    for (int run = 0; run < 3; run++) {
+        double direct_ns = measure(original_imp, iterations);
+        double callpop_ns = measure(callpop, iterations);
+        double jmp_ns = measure(jmp, iterations);
+        double reg_ns = measure(reg, iterations);
+
+        char jmp_delta[32];
+        snprintf(jmp_delta, sizeof(jmp_delta), "%+.1f%%", 100.0 * (jmp_ns - callpop_ns) / callpop_ns);
+
+        printf("%-12.3f %-12.3f %-12.3f %-12.3f %-20s %+.1f%%\n", direct_ns, callpop_ns, jmp_ns, reg_ns, jmp_delta, 100.0 * (reg_ns - jmp_ns) / jmp_ns);
+    }
+
+    return 0;
+}
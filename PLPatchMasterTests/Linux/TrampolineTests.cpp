@@ -0,0 +1,255 @@
+/*
+ * Author: Landon Fuller <landon@landonf.org>
+ *
+ * Copyright (c) 2015 Landon Fuller <landon@landonf.org>.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#include "PMTest.hpp"
+#include "TrampolineTable.hpp"
+#include "PLBlockLayout.h"
+
+#include <string.h>
+#include <unistd.h>
+
+#include <set>
+#include <string>
+
+extern "C" {
+#include "blockimp_x86_64.h"
+#include "blockimp_x86_64_stret.h"
+}
+
+using namespace patchmaster;
+
+/*
+ * Tests for the Linux memfd TrampolineTable backend, and the x86-64 block trampoline dispatchers.
+ */
+
+/* The patch state constructed by the block trampoline dispatchers; see PLPatchIMP in PLPatchMaster.h */
+struct PatchIMP {
+    void *self;
+    void *origIMP;
+    void *selector;
+};
+
+/* Configuration entry words; see blockimp_x86_64.tramp */
+enum {
+    CONFIG_BLOCK = 0,
+    CONFIG_DISABLED = 1,
+    CONFIG_IMP = 2,
+    CONFIG_SEL = 3
+};
+
+#define TEST_SEL ((void *) 0x5E1)
+
+struct stret_value {
+    unsigned long value[4];
+};
+
+typedef unsigned long (*imp_t)(void *self, void *sel, unsigned long value);
+typedef stret_value (*stret_imp_t)(void *self, void *sel, unsigned long value);
+
+static unsigned long original_imp (void *self, void *sel, unsigned long value) {
+    PMTestAssert(sel == TEST_SEL, "original IMP received incorrect selector %p", sel);
+    return value;
+}
+
+static stret_value original_stret_imp (void *self, void *sel, unsigned long value) {
+    PMTestAssert(sel == TEST_SEL, "original IMP received incorrect selector %p", sel);
+    return stret_value { { value, value, value, value } };
+}
+
+static unsigned long block_invoke (Block_layout *block, PatchIMP *patch, unsigned long value) {
+    return ((imp_t) patch->origIMP)(patch->self, patch->selector, value) + 1;
+}
+
+static stret_value block_stret_invoke (Block_layout *block, PatchIMP *patch, unsigned long value) {
+    stret_value result = ((stret_imp_t) patch->origIMP)(patch->self, patch->selector, value);
+    result.value[3]++;
+    return result;
+}
+
+/* Return the permissions of the mapping containing @a address, as reported by /proc/self/maps */
+static std::string mapping_perms (const void *address) {
+    FILE *maps = fopen("/proc/self/maps", "r");
+    PMTestAssert(maps != nullptr, "could not open /proc/self/maps");
+
+    char line[512];
+    std::string perms;
+    while (fgets(line, sizeof(line), maps) != nullptr) {
+        uintptr_t start, end;
+        char p[5];
+        if (sscanf(line, "%lx-%lx %4s", &start, &end, p) != 3)
+            continue;
+
+        if ((uintptr_t) address >= start && (uintptr_t) address < end) {
+            perms = p;
+            break;
+        }
+    }
+
+    fclose(maps);
+    return perms;
+}
+
+/* Configure @a trampoline to dispatch to @a block, forwarding to @a imp */
+static void configure (TrampolineTable &table, void *trampoline, Block_layout *block, void *imp) {
+    *table.config_entry(trampoline, CONFIG_BLOCK) = block;
+    *table.config_entry(trampoline, CONFIG_DISABLED) = nullptr;
+    *table.config_entry(trampoline, CONFIG_IMP) = imp;
+    *table.config_entry(trampoline, CONFIG_SEL) = TEST_SEL;
+}
+
+/* Configuration entries must be located at the trampoline's page offset within the preceding config planes */
+static void testConfigLayout () {
+    const pm_trampoline_config *config = &pl_blockimp_patch_table_page_config;
+    TrampolineTable table(config);
+
+    uint8_t *trampoline = (uint8_t *) table.alloc();
+    PMTestAssert(trampoline != nullptr, "allocation failed");
+    PMTestAssert((uintptr_t) trampoline % config->trampoline_size == 0, "misaligned trampoline %p", trampoline);
+
+    PMTestAssert((uint8_t *) table.config_ptr(trampoline) == trampoline - config->page_size, "incorrect config_ptr()");
+    PMTestAssert((uint8_t *) table.config_entry(trampoline, CONFIG_DISABLED) == trampoline - config->page_size + sizeof(void *), "incorrect plane 0 entry");
+    PMTestAssert((uint8_t *) table.config_entry(trampoline, CONFIG_IMP) == trampoline - (2 * config->page_size), "incorrect plane 1 entry");
+    PMTestAssert((uint8_t *) table.config_entry(trampoline, CONFIG_SEL) == trampoline - (2 * config->page_size) + sizeof(void *), "incorrect plane 1 entry");
+
+    table.free(trampoline);
+}
+
+/* Trampoline pages must be mapped read-only and executable; configuration pages must be writable, and not
+ * executable */
+static void testPageProtections () {
+    TrampolineTable table(&pl_blockimp_patch_table_page_config);
+
+    void *trampoline = table.alloc();
+    PMTestAssert(trampoline != nullptr, "allocation failed");
+
+    std::string tramp_perms = mapping_perms(trampoline);
+    PMTestAssert(tramp_perms.compare(0, 3, "r-x") == 0, "trampoline page mapped %s", tramp_perms.c_str());
+
+    for (size_t i = CONFIG_BLOCK; i <= CONFIG_SEL; i++) {
+        std::string config_perms = mapping_perms(table.config_entry(trampoline, i));
+        PMTestAssert(config_perms.compare(0, 3, "rw-") == 0, "config page mapped %s", config_perms.c_str());
+    }
+
+    table.free(trampoline);
+}
+
+/* Bulk allocations spanning multiple pages must return distinct trampolines, and freed trampolines must be
+ * reused */
+static void testBulkAlloc () {
+    const pm_trampoline_config *config = &pl_blockimp_patch_table_page_config;
+    TrampolineTable table(config);
+
+    size_t count = (config->trampoline_count * 2) + 1;
+    std::vector<void *> trampolines(count);
+    PMTestAssert(table.alloc(count, trampolines.data()), "bulk allocation failed");
+
+    std::set<void *> unique(trampolines.begin(), trampolines.end());
+    PMTestAssert(unique.size() == count, "bulk allocation returned %zu duplicate trampolines", count - unique.size());
+
+    /* Every trampoline must be usable */
+    Block_layout block = { nullptr, 0, 0, (void (*)(void *, ...)) block_invoke, nullptr };
+    for (void *trampoline : trampolines) {
+        configure(table, trampoline, &block, (void *) original_imp);
+        PMTestAssert(((imp_t) trampoline)(nullptr, TEST_SEL, 41) == 42, "dispatch via %p failed", trampoline);
+    }
+
+    table.free(trampolines.data(), count);
+
+    void *reused = table.alloc();
+    PMTestAssert(unique.count(reused) == 1, "freed trampolines were not reused");
+    table.free(reused);
+}
+
+/* The dispatcher must pass the block a PLPatchIMP populated from the trampoline's configuration, and
+ * tail-call the original IMP when disabled */
+static void testDispatch () {
+    TrampolineTable table(&pl_blockimp_patch_table_page_config);
+    void *trampoline = table.alloc();
+    PMTestAssert(trampoline != nullptr, "allocation failed");
+
+    Block_layout block = { nullptr, 0, 0, (void (*)(void *, ...)) block_invoke, nullptr };
+    configure(table, trampoline, &block, (void *) original_imp);
+
+    int self;
+    PMTestAssert(((imp_t) trampoline)(&self, TEST_SEL, 41) == 42, "incorrect patched result");
+
+    *table.config_entry(trampoline, CONFIG_DISABLED) = (void *) 1;
+    PMTestAssert(((imp_t) trampoline)(&self, TEST_SEL, 41) == 41, "disabled patch was invoked");
+
+    table.free(trampoline);
+}
+
+/* The stret dispatcher must preserve the structure return pointer */
+static void testStretDispatch () {
+    TrampolineTable table(&pl_blockimp_patch_table_stret_page_config);
+    void *trampoline = table.alloc();
+    PMTestAssert(trampoline != nullptr, "allocation failed");
+
+    Block_layout block = { nullptr, BLOCK_USE_STRET, 0, (void (*)(void *, ...)) block_stret_invoke, nullptr };
+    configure(table, trampoline, &block, (void *) original_stret_imp);
+
+    int self;
+    stret_value result = ((stret_imp_t) trampoline)(&self, TEST_SEL, 41);
+    PMTestAssert(result.value[0] == 41 && result.value[3] == 42, "incorrect patched result");
+
+    *table.config_entry(trampoline, CONFIG_DISABLED) = (void *) 1;
+    result = ((stret_imp_t) trampoline)(&self, TEST_SEL, 41);
+    PMTestAssert(result.value[0] == 41 && result.value[3] == 41, "disabled patch was invoked");
+
+    table.free(trampoline);
+}
+
+/* A trampoline must only be reported as belonging to the table from which it was allocated */
+static void testContains () {
+    TrampolineTable table(&pl_blockimp_patch_table_page_config);
+    TrampolineTable stret_table(&pl_blockimp_patch_table_stret_page_config);
+
+    void *trampoline = table.alloc();
+    void *stret_trampoline = stret_table.alloc();
+    PMTestAssert(trampoline != nullptr && stret_trampoline != nullptr, "allocation failed");
+
+    PMTestAssert(table.contains(trampoline), "trampoline not found in its own table");
+    PMTestAssert(!table.contains(stret_trampoline), "stret trampoline found in the wrong table");
+    PMTestAssert(stret_table.contains(stret_trampoline), "stret trampoline not found in its own table");
+    PMTestAssert(!stret_table.contains(trampoline), "trampoline found in the wrong table");
+    PMTestAssert(!table.contains((void *) original_imp), "non-trampoline address found in table");
+
+    table.free(trampoline);
+    stret_table.free(stret_trampoline);
+}
+
+int main (int argc, char *argv[]) {
+    PMTestRun(testConfigLayout);
+    PMTestRun(testPageProtections);
+    PMTestRun(testBulkAlloc);
+    PMTestRun(testDispatch);
+    PMTestRun(testStretDispatch);
+    PMTestRun(testContains);
+    return 0;
+}
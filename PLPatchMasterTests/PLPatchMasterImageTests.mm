@@ -0,0 +1,105 @@
+/*
+ * Author: Landon Fuller <landonf@plausiblelabs.com>
+ *
+ * Copyright (c) 2013-2015 Plausible Labs Cooperative, Inc.
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#import <XCTest/XCTest.h>
+#import <objc/runtime.h>
+#import <dlfcn.h>
+#import <mach-o/getsect.h>
+
+#import "SymbolBinder.hpp"
+
+using namespace patchmaster;
+
+@interface PLPatchMasterImageTests : XCTestCase
+@end
+
+/**
+ * Tests for the in-memory Mach-O image support used to locate per-image Objective-C metadata.
+ */
+@implementation PLPatchMasterImageTests
+
+/**
+ * Return the header of the image defining @a cls.
+ */
+static const pl_mach_header_t *image_for_class (Class cls) {
+    Dl_info info;
+    if (dladdr((__bridge const void *) cls, &info) == 0)
+        return NULL;
+    
+    return (const pl_mach_header_t *) info.dli_fbase;
+}
+
+/* FindSection() must return the same section as the system's getsectiondata() */
+- (void) testFindSection {
+    const pl_mach_header_t *header = image_for_class([self class]);
+    XCTAssertTrue(header != NULL);
+    
+    size_t size;
+    const void *text = LocalImage::FindSection(header, "__TEXT", "__text", &size);
+    XCTAssertTrue(text != NULL);
+    
+    unsigned long expectedSize;
+    const void *expected = getsectiondata(header, "__TEXT", "__text", &expectedSize);
+    XCTAssertEqual(expected, text);
+    XCTAssertEqual((size_t) expectedSize, size);
+    
+    /* Sections that do not exist (or are in a different segment) must not be found */
+    XCTAssertTrue(LocalImage::FindSection(header, "__TEXT", "__pl_no_such_section", &size) == NULL);
+    XCTAssertTrue(LocalImage::FindSection(header, "__DATA", "__text", &size) == NULL);
+}
+
+#if __OBJC2__
+/* The image's __objc_classlist must contain exactly the classes defined by that image */
+- (void) testFindClassList {
+    const pl_mach_header_t *header = image_for_class([self class]);
+    XCTAssertTrue(header != NULL);
+    
+    /* Depending on the linker, the class list may be in any of the __DATA segments */
+    NSMutableSet *names = [NSMutableSet set];
+    for (const char *segname : { "__DATA", "__DATA_CONST", "__DATA_DIRTY" }) {
+        size_t size;
+        auto classes = (const Class *) LocalImage::FindSection(header, segname, "__objc_classlist", &size);
+        if (classes == NULL)
+            continue;
+        
+        XCTAssertEqual((size_t) 0, size % sizeof(Class));
+        for (size_t i = 0; i < size / sizeof(Class); i++)
+            [names addObject: NSStringFromClass(classes[i])];
+    }
+    
+    XCTAssertTrue([names containsObject: NSStringFromClass([self class])]);
+    XCTAssertTrue([names containsObject: @"PLPatchMasterTests"]);
+    
+    /* Classes defined by other images must not be included */
+    XCTAssertFalse([names containsObject: @"NSObject"]);
+    XCTAssertFalse([names containsObject: @"XCTestCase"]);
+}
+#endif /* __OBJC2__ */
+
+@end
@@ -7,12 +7,19 @@
 //
 
 #import <XCTest/XCTest.h>
+#import <objc/runtime.h>
+#import <dlfcn.h>
 #import "PLPatchMaster.h"
 
 @interface PLPatchMasterTests : XCTestCase
 
 @end
 
+/** The interface of the class defined by the PLPatchMasterClassFixture bundle. */
+@protocol PLPatchMasterClassFixture <NSObject>
+- (NSString *) fixtureValue;
+@end
+
 @implementation PLPatchMasterTests
 
 - (NSString *) patchTargetWithArgument: (NSString *) expected {
@@ -30,6 +37,193 @@
     XCTAssertEqualObjects(@"[PATCHED]: Result", [self patchTargetWithArgument: @"Result"], @"Incorrect value returned");
 }
 
+- (NSUInteger) dispatchTargetWithArgument: (NSUInteger) value {
+    return value;
+}
+
+- (void) testDispatchPerformance {
+    [PLPatchMasterTests pl_patchInstanceSelector: @selector(dispatchTargetWithArgument:) withReplacementBlock: ^(PLPatchIMP *patch, NSUInteger value) {
+        return PLPatchIMPFoward(patch, NSUInteger (*)(id, SEL, NSUInteger), value) + 1;
+    }];
+    
+    XCTAssertEqual(2, [self dispatchTargetWithArgument: 1]);
+    
+    /* Measure the cost of dispatching through the patch trampoline */
+    [self measureBlock: ^{
+        NSUInteger total = 0;
+        for (NSUInteger i = 0; i < 1000000; i++)
+            total += [self dispatchTargetWithArgument: i];
+        XCTAssertNotEqual(0, total);
+    }];
+}
+
+- (NSUInteger) registerDispatchTargetWithArgument: (NSUInteger) value {
+    return value;
+}
+
+- (void) testRegisterDispatchPerformance {
+    [PLPatchMasterTests pl_patchInstanceSelector: @selector(registerDispatchTargetWithArgument:) withReplacementBlock: ^(const PLPatchIMPSlot *slot, id target, NSUInteger value) {
+        return PLPatchIMPSlotForward(slot, target, NSUInteger (*)(id, SEL, NSUInteger), value) + 1;
+    }];
+    
+    XCTAssertEqual(2, [self registerDispatchTargetWithArgument: 1]);
+    
+    /* Measure the cost of dispatching through the register ABI trampoline; compare with testDispatchPerformance */
+    [self measureBlock: ^{
+        NSUInteger total = 0;
+        for (NSUInteger i = 0; i < 1000000; i++)
+            total += [self registerDispatchTargetWithArgument: i];
+        XCTAssertNotEqual(0, total);
+    }];
+}
+
+- (NSString *) chainPatchTargetWithArgument: (NSString *) expected {
+    return expected;
+}
+
+- (void) testPatchChain {
+    PLPatchMaster *master = [PLPatchMaster master];
+    SEL selector = @selector(chainPatchTargetWithArgument:);
+    
+    /* Hooks are removed by identity; assigning the blocks to strong variables copies them to the heap */
+    id first = ^(PLPatchIMP *patch, NSString *expected) {
+        return [NSString stringWithFormat: @"1(%@)", PLPatchIMPFoward(patch, NSString *(*)(id, SEL, NSString *), expected)];
+    };
+    
+    id second = ^(PLPatchIMP *patch, NSString *expected) {
+        return [NSString stringWithFormat: @"2(%@)", PLPatchIMPFoward(patch, NSString *(*)(id, SEL, NSString *), expected)];
+    };
+    
+    id third = ^(PLPatchIMP *patch, NSString *expected) {
+        return [NSString stringWithFormat: @"3(%@)", PLPatchIMPFoward(patch, NSString *(*)(id, SEL, NSString *), expected)];
+    };
+    
+    /* The most recently registered hook is outermost */
+    XCTAssertTrue([master patchInstancesWithClass: [PLPatchMasterTests class] selector: selector replacementBlock: first]);
+    XCTAssertTrue([master patchInstancesWithClass: [PLPatchMasterTests class] selector: selector replacementBlock: second]);
+    XCTAssertTrue([master patchInstancesWithClass: [PLPatchMasterTests class] selector: selector replacementBlock: third]);
+    XCTAssertEqualObjects(@"3(2(1(Result)))", [self chainPatchTargetWithArgument: @"Result"]);
+    
+    /* Removing a middle hook must leave the remainder of the chain in place, without modifying the method */
+    IMP head = class_getMethodImplementation([PLPatchMasterTests class], selector);
+    XCTAssertTrue([master removePatchOfInstancesWithClass: [PLPatchMasterTests class] selector: selector replacementBlock: second]);
+    XCTAssertEqual(head, class_getMethodImplementation([PLPatchMasterTests class], selector));
+    XCTAssertEqualObjects(@"3(1(Result))", [self chainPatchTargetWithArgument: @"Result"]);
+    
+    /* Removing the head must restore the next hook */
+    XCTAssertTrue([master removePatchOfInstancesWithClass: [PLPatchMasterTests class] selector: selector replacementBlock: third]);
+    XCTAssertEqualObjects(@"1(Result)", [self chainPatchTargetWithArgument: @"Result"]);
+    
+    XCTAssertTrue([master removePatchOfInstancesWithClass: [PLPatchMasterTests class] selector: selector replacementBlock: first]);
+    XCTAssertFalse([master removePatchOfInstancesWithClass: [PLPatchMasterTests class] selector: selector replacementBlock: first]);
+    XCTAssertEqualObjects(@"Result", [self chainPatchTargetWithArgument: @"Result"]);
+}
+
+- (NSString *) observedChainPatchTargetWithArgument: (NSString *) expected {
+    return expected;
+}
+
+static void observed_chain_callback (id self, SEL _cmd, void *context) {
+    (*(NSUInteger *) context)++;
+}
+
+- (void) testPatchChainBehindObserver {
+    PLPatchMaster *master = [PLPatchMaster master];
+    SEL selector = @selector(observedChainPatchTargetWithArgument:);
+    NSUInteger observed = 0;
+    
+    id first = ^(PLPatchIMP *patch, NSString *expected) {
+        return [NSString stringWithFormat: @"1(%@)", PLPatchIMPFoward(patch, NSString *(*)(id, SEL, NSString *), expected)];
+    };
+    
+    id second = ^(PLPatchIMP *patch, NSString *expected) {
+        return [NSString stringWithFormat: @"2(%@)", PLPatchIMPFoward(patch, NSString *(*)(id, SEL, NSString *), expected)];
+    };
+    
+    /* Replace the method's implementation with an observer, and then add a second block patch */
+    XCTAssertTrue([master patchInstancesWithClass: [PLPatchMasterTests class] selector: selector replacementBlock: first]);
+    XCTAssertTrue([master observeInstancesWithClass: [PLPatchMasterTests class] selector: selector observer: observed_chain_callback context: &observed]);
+    XCTAssertTrue([master patchInstancesWithClass: [PLPatchMasterTests class] selector: selector replacementBlock: second]);
+    
+    /* Both block patches must remain in a single chain behind the observer */
+    XCTAssertEqualObjects(@"2(1(Result))", [self observedChainPatchTargetWithArgument: @"Result"]);
+    XCTAssertEqual((NSUInteger) 1, observed);
+    
+    /* The earlier patch must remain reachable */
+    XCTAssertTrue([master setEnabled: NO forPatchOfInstancesWithClass: [PLPatchMasterTests class] selector: selector replacementBlock: first]);
+    XCTAssertEqualObjects(@"2(Result)", [self observedChainPatchTargetWithArgument: @"Result"]);
+    XCTAssertTrue([master setEnabled: YES forPatchOfInstancesWithClass: [PLPatchMasterTests class] selector: selector replacementBlock: first]);
+    
+    XCTAssertTrue([master removePatchOfInstancesWithClass: [PLPatchMasterTests class] selector: selector replacementBlock: first]);
+    XCTAssertEqualObjects(@"2(Result)", [self observedChainPatchTargetWithArgument: @"Result"]);
+    
+    XCTAssertTrue([master removePatchOfInstancesWithClass: [PLPatchMasterTests class] selector: selector replacementBlock: second]);
+    XCTAssertEqualObjects(@"Result", [self observedChainPatchTargetWithArgument: @"Result"]);
+    XCTAssertEqual((NSUInteger) 4, observed);
+}
+
+- (NSString *) togglePatchTargetWithArgument: (NSString *) expected {
+    return expected;
+}
+
+- (void) testTogglePatch {
+    PLPatchMaster *master = [PLPatchMaster master];
+    SEL selector = @selector(togglePatchTargetWithArgument:);
+    
+    id patch = ^(PLPatchIMP *patch, NSString *expected) {
+        return [NSString stringWithFormat: @"[PATCHED]: %@", PLPatchIMPFoward(patch, NSString *(*)(id, SEL, NSString *), expected)];
+    };
+    
+    XCTAssertTrue([master patchInstancesWithClass: [PLPatchMasterTests class] selector: selector replacementBlock: patch]);
+    IMP imp = class_getMethodImplementation([PLPatchMasterTests class], selector);
+    
+    /* Disabling the patch must forward directly to the original implementation, without modifying the method */
+    XCTAssertTrue([master setEnabled: NO forPatchOfInstancesWithClass: [PLPatchMasterTests class] selector: selector replacementBlock: patch]);
+    XCTAssertEqualObjects(@"Result", [self togglePatchTargetWithArgument: @"Result"]);
+    XCTAssertEqual(imp, class_getMethodImplementation([PLPatchMasterTests class], selector));
+    
+    XCTAssertTrue([master setEnabled: YES forPatchOfInstancesWithClass: [PLPatchMasterTests class] selector: selector replacementBlock: patch]);
+    XCTAssertEqualObjects(@"[PATCHED]: Result", [self togglePatchTargetWithArgument: @"Result"]);
+}
+
+- (NSString *) futurePatchTargetWithArgument: (NSString *) expected {
+    return expected;
+}
+
+- (void) testPatchFutureClassAlreadyLoaded {
+    /* A future patch targeting an already loaded class must be applied immediately */
+    [[PLPatchMaster master] patchInstancesWithFutureClassName: NSStringFromClass([PLPatchMasterTests class]) selector: @selector(futurePatchTargetWithArgument:) replacementBlock: ^(PLPatchIMP *patch, NSString *expected) {
+        NSString *originalResult = PLPatchIMPFoward(patch, NSString *(*)(id, SEL, NSString *), expected);
+        return [NSString stringWithFormat: @"[PATCHED]: %@", originalResult];
+    }];
+
+    XCTAssertEqualObjects(@"[PATCHED]: Result", [self futurePatchTargetWithArgument: @"Result"], @"Incorrect value returned");
+}
+
+#if !TARGET_OS_IPHONE
+- (void) testPatchFutureClassOnBundleLoad {
+    NSString *bundlePath = [[NSBundle bundleForClass: [self class]] pathForResource: @"PLPatchMasterClassFixture" ofType: @"bundle"];
+    NSBundle *bundle = [NSBundle bundleWithPath: bundlePath];
+    XCTAssertNotNil(bundle);
+    XCTAssertNil(NSClassFromString(@"PLPatchMasterClassFixture"), @"Fixture must not be loaded prior to this test");
+    
+    /* The patch must remain pending until the image defining the class is loaded */
+    [[PLPatchMaster master] patchInstancesWithFutureClassName: @"PLPatchMasterClassFixture" selector: @selector(fixtureValue) replacementBlock: ^(PLPatchIMP *patch) {
+        NSString *originalResult = PLPatchIMPFoward(patch, NSString *(*)(id, SEL));
+        return [NSString stringWithFormat: @"[PATCHED]: %@", originalResult];
+    }];
+    
+    XCTAssertTrue([bundle load]);
+    [[PLPatchMaster master] flushImageLoads];
+    
+    Class cls = NSClassFromString(@"PLPatchMasterClassFixture");
+    XCTAssertNotNil(cls);
+    
+    id<PLPatchMasterClassFixture> fixture = [[cls alloc] init];
+    XCTAssertEqualObjects(@"[PATCHED]: Fixture", [fixture fixtureValue], @"Pending patch was not applied on load");
+}
+#endif /* !TARGET_OS_IPHONE */
+
 struct stret_return {
     char value[30];
 };
@@ -62,6 +256,66 @@ struct stret_return {
     XCTAssertTrue(strcmp(ret.value, "jello") == 0, @"Incorrect value returned: '%s'", ret.value);
 }
 
+- (double) observeTargetWithArgument: (NSUInteger) value scale: (double) scale {
+    return value * scale;
+}
+
+- (struct stret_return) observeStretTargetWithArgument: (NSString *) expected {
+    return [self stretPatchTargetWithArgument: expected];
+}
+
+static void observe_callback (id self, SEL _cmd, void *context) {
+    NSMutableArray *observed = (__bridge NSMutableArray *) context;
+    [observed addObject: @[self, NSStringFromSelector(_cmd)]];
+}
+
+- (void) testObserveInstances {
+    NSMutableArray *observed = [NSMutableArray array];
+    
+    XCTAssertTrue([[PLPatchMaster master] observeInstancesWithClass: [PLPatchMasterTests class] selector: @selector(observeTargetWithArgument:scale:) observer: observe_callback context: (__bridge void *) observed]);
+    XCTAssertTrue([[PLPatchMaster master] observeInstancesWithClass: [PLPatchMasterTests class] selector: @selector(observeStretTargetWithArgument:) observer: observe_callback context: (__bridge void *) observed]);
+    
+    /* All arguments must be passed through to the original implementation */
+    XCTAssertEqual(5.0, [self observeTargetWithArgument: 2 scale: 2.5]);
+    
+    struct stret_return ret = [self observeStretTargetWithArgument: @"hello"];
+    XCTAssertTrue(strcmp(ret.value, "hello") == 0, @"Incorrect value returned: '%s'", ret.value);
+    
+    NSArray *expected = @[
+        @[self, NSStringFromSelector(@selector(observeTargetWithArgument:scale:))],
+        @[self, NSStringFromSelector(@selector(observeStretTargetWithArgument:))]
+    ];
+    XCTAssertEqualObjects(expected, observed);
+}
+
+#if defined(__x86_64__)
+static double interpose_target (long a, long b, long c, long d, long e, long f, long g, double x, double y) {
+    return a + b + c + d + e + f + g + x + y;
+}
+
+static void interpose_pre (void *context, void *function, PLPatchInterposeArguments *arguments) {
+    /* Double the first argument */
+    arguments->gpr[0] *= 2;
+}
+
+static void interpose_post (void *context, void *function, PLPatchInterposeResults *results) {
+    double result;
+    memcpy(&result, results->vector[0], sizeof(result));
+    *(double *) context = result;
+}
+
+- (void) testInterposeFunction {
+    double observed = 0;
+    double (*interposed)(long, long, long, long, long, long, long, double, double);
+    interposed = (double (*)(long, long, long, long, long, long, long, double, double)) [[PLPatchMaster master] interposeFunction: (void *) interpose_target preHook: interpose_pre postHook: interpose_post context: &observed];
+    XCTAssertTrue(interposed != NULL);
+
+    /* The seventh argument is passed on the stack */
+    XCTAssertEqual(32.5, interposed(2, 2, 3, 4, 5, 6, 7, 1.0, 0.5));
+    XCTAssertEqual(32.5, observed);
+}
+#endif
+
 static CFIndex patched_CFGetRetainCount (CFTypeRef ref) {
     return 0xABBA;
 }
@@ -79,6 +333,305 @@ static CFIndex patched_CFGetRetainCount (CFTypeRef ref) {
     XCTAssertNotEqual(0xABBA, CFGetRetainCount((__bridge CFTypeRef) [NSArray array]));
 }
 
+- (void) testRebindSymbolWithBlock {
+    __block NSUInteger calls = 0;
+    
+    XCTAssertTrue([[PLPatchMaster master] rebindSymbol: @"_CFGetRetainCount" fromImage: kPLPatchImageCoreFoundation replacementBlock: ^(PLPatchFunction *patch, CFTypeRef ref) {
+        calls++;
+        return PLPatchFunctionForward(patch, CFIndex (*)(CFTypeRef), ref) + 0xABBA;
+    }]);
+    
+    /* The original function must be reachable via the patch context */
+    NSObject *obj = [NSObject new];
+    CFIndex (*orig)(CFTypeRef) = (CFIndex (*)(CFTypeRef)) dlsym(RTLD_DEFAULT, "CFGetRetainCount");
+    XCTAssertEqual(0xABBA + orig((__bridge CFTypeRef) obj), CFGetRetainCount((__bridge CFTypeRef) obj));
+    XCTAssertEqual(1, calls);
+    
+    XCTAssertTrue([[PLPatchMaster master] restoreSymbol: @"_CFGetRetainCount" fromImage: kPLPatchImageCoreFoundation]);
+    XCTAssertEqual(orig((__bridge CFTypeRef) obj), CFGetRetainCount((__bridge CFTypeRef) obj));
+    XCTAssertEqual(1, calls);
+}
+
+/* Integer arguments must be shifted, and floating point arguments passed through unmodified */
+- (void) testRebindSymbolWithBlockMixedArguments {
+    XCTAssertTrue([[PLPatchMaster master] rebindSymbol: @"_CFDateCreate" fromImage: kPLPatchImageCoreFoundation replacementBlock: ^(PLPatchFunction *patch, CFAllocatorRef allocator, CFAbsoluteTime at) {
+        return PLPatchFunctionForward(patch, CFDateRef (*)(CFAllocatorRef, CFAbsoluteTime), allocator, at + 10.0);
+    }]);
+    
+    CFDateRef date = CFDateCreate(kCFAllocatorDefault, 42.0);
+    XCTAssertEqual(52.0, CFDateGetAbsoluteTime(date));
+    CFRelease(date);
+    
+    XCTAssertTrue([[PLPatchMaster master] restoreSymbol: @"_CFDateCreate" fromImage: kPLPatchImageCoreFoundation]);
+}
+
+/* Blocks with arguments that would be passed on the stack must be rejected */
+- (void) testRebindSymbolWithBlockStackArguments {
+    PLPatchMaster *master = [PLPatchMaster master];
+    
+    XCTAssertFalse([master rebindSymbol: @"_CFGetRetainCount" fromImage: kPLPatchImageCoreFoundation replacementBlock: ^(PLPatchFunction *patch, void *a0, void *a1, void *a2, void *a3, void *a4, void *a5, void *a6) {
+        return (CFIndex) 0;
+    }]);
+    
+    XCTAssertFalse([master rebindSymbol: @"_CFGetRetainCount" fromImage: kPLPatchImageCoreFoundation replacementBlock: ^(PLPatchFunction *patch, double d0, double d1, double d2, double d3, double d4, double d5, double d6, double d7, double d8) {
+        return (CFIndex) 0;
+    }]);
+    
+    XCTAssertFalse([master rebindSymbol: @"_CFGetRetainCount" fromImage: kPLPatchImageCoreFoundation replacementBlock: ^(PLPatchFunction *patch, struct stret_return value) {
+        return (CFIndex) 0;
+    }]);
+}
+
+- (void) testAsyncRebindSymbol {
+    CFIndex (*orig)(CFTypeRef) = &CFGetRetainCount;
+    
+    PLPatchCompletion *completion = [[PLPatchMaster master] asyncRebindSymbol: @"_CFGetRetainCount" fromImage: kPLPatchImageCoreFoundation replacementAddress: (uintptr_t) patched_CFGetRetainCount];
+    XCTAssertTrue([completion waitWithTimeout: 30]);
+    XCTAssertTrue([completion succeeded]);
+    XCTAssertEqual(0xABBA, CFGetRetainCount((__bridge CFTypeRef) [NSArray array]));
+    
+    /* Restore the original; the barrier must not complete until the preceding rebinding has been applied */
+    [[PLPatchMaster master] asyncRebindSymbol: @"_CFGetRetainCount" fromImage: kPLPatchImageCoreFoundation replacementAddress: (uintptr_t) orig];
+    [[[PLPatchMaster master] allImagesProcessed] wait];
+    XCTAssertNotEqual(0xABBA, CFGetRetainCount((__bridge CFTypeRef) [NSArray array]));
+}
+
+static CFIndex filtered_CFGetRetainCount (CFTypeRef ref) {
+    return 0xFAFA;
+}
+
+- (void) testRebindSymbolWithImageFilter {
+    CFIndex (*orig)(CFTypeRef) = &CFGetRetainCount;
+    NSString *testImage = [[NSBundle bundleForClass: [self class]] executablePath];
+
+    /* Excluding our own image must leave our references untouched */
+    PLPatchImageFilter *filter = [PLPatchImageFilter filter];
+    [filter excludeImagesWithPathPrefix: testImage];
+    [[PLPatchMaster master] rebindSymbol: @"_CFGetRetainCount" fromImage: kPLPatchImageCoreFoundation replacementAddress: (uintptr_t) filtered_CFGetRetainCount imageFilter: filter];
+    XCTAssertNotEqual(0xFAFA, CFGetRetainCount((__bridge CFTypeRef) [NSArray array]));
+
+    /* Including only our own image must rebind our references */
+    filter = [PLPatchImageFilter filter];
+    [filter excludeImagesMatchingPattern: @"/System/*"];
+    [filter includeImagesWithPathPrefix: testImage];
+    [[PLPatchMaster master] rebindSymbol: @"_CFGetRetainCount" fromImage: kPLPatchImageCoreFoundation replacementAddress: (uintptr_t) filtered_CFGetRetainCount imageFilter: filter];
+    XCTAssertEqual(0xFAFA, CFGetRetainCount((__bridge CFTypeRef) [NSArray array]));
+
+    /* Restore the original */
+    [[PLPatchMaster master] rebindSymbol: @"_CFGetRetainCount" fromImage: kPLPatchImageCoreFoundation replacementAddress: (uintptr_t) orig];
+}
+
+- (void) testRebindSymbolWithImporters {
+    CFIndex (*orig)(CFTypeRef) = &CFGetRetainCount;
+    NSString *testImage = [[NSBundle bundleForClass: [self class]] executablePath];
+
+    /* A predicate that rejects our image must leave our references untouched */
+    __block BOOL sawTestImage = NO;
+    [[PLPatchMaster master] rebindSymbol: @"_CFGetRetainCount" fromImage: kPLPatchImageCoreFoundation replacementAddress: (uintptr_t) filtered_CFGetRetainCount importerPredicate: ^(NSString *imagePath) {
+        if ([imagePath isEqualToString: testImage])
+            sawTestImage = YES;
+        return NO;
+    }];
+    XCTAssertTrue(sawTestImage, @"Predicate was not consulted for the test image");
+    XCTAssertNotEqual(0xFAFA, CFGetRetainCount((__bridge CFTypeRef) [NSArray array]));
+
+    /* Naming our image as the sole importer must rebind our references */
+    [[PLPatchMaster master] rebindSymbol: @"_CFGetRetainCount" fromImage: kPLPatchImageCoreFoundation replacementAddress: (uintptr_t) filtered_CFGetRetainCount importers: @[testImage]];
+    XCTAssertEqual(0xFAFA, CFGetRetainCount((__bridge CFTypeRef) [NSArray array]));
+
+    /* Restore the original */
+    [[PLPatchMaster master] rebindSymbol: @"_CFGetRetainCount" fromImage: kPLPatchImageCoreFoundation replacementAddress: (uintptr_t) orig];
+}
+
+static CFIndex restored_CFGetRetainCount (CFTypeRef ref) {
+    return 0xCAFE;
+}
+
+- (void) testRestoreSymbol {
+    CFIndex original = CFGetRetainCount((__bridge CFTypeRef) [NSArray array]);
+
+    [[PLPatchMaster master] rebindSymbol: @"_CFGetRetainCount" fromImage: kPLPatchImageCoreFoundation replacementAddress: (uintptr_t) restored_CFGetRetainCount];
+    [[PLPatchMaster master] rebindSymbol: @"_CFGetRetainCount" replacementAddress: (uintptr_t) filtered_CFGetRetainCount];
+    XCTAssertEqual(0xFAFA, CFGetRetainCount((__bridge CFTypeRef) [NSArray array]));
+
+    /* Removing the earlier rebinding must leave the later rebinding in place */
+    XCTAssertTrue([[PLPatchMaster master] restoreSymbol: @"_CFGetRetainCount" fromImage: kPLPatchImageCoreFoundation]);
+    XCTAssertEqual(0xFAFA, CFGetRetainCount((__bridge CFTypeRef) [NSArray array]));
+
+    /* Removing the remaining rebinding must restore the original binding */
+    XCTAssertTrue([[PLPatchMaster master] restoreSymbol: @"_CFGetRetainCount"]);
+    XCTAssertEqual(original, CFGetRetainCount((__bridge CFTypeRef) [NSArray array]));
+
+    XCTAssertFalse([[PLPatchMaster master] restoreSymbol: @"_CFGetRetainCount"]);
+}
+
+- (void) testRestoreSymbolWithSharedValue {
+    CFIndex original = CFGetRetainCount((__bridge CFTypeRef) [NSArray array]);
+
+    /* Both rebindings write the same value; the second must still take ownership of the bind sites */
+    [[PLPatchMaster master] rebindSymbol: @"_CFGetRetainCount" fromImage: kPLPatchImageCoreFoundation replacementAddress: (uintptr_t) filtered_CFGetRetainCount];
+    [[PLPatchMaster master] rebindSymbol: @"_CFGetRetainCount" replacementAddress: (uintptr_t) filtered_CFGetRetainCount];
+    XCTAssertEqual(0xFAFA, CFGetRetainCount((__bridge CFTypeRef) [NSArray array]));
+
+    /* Removing the earlier rebinding must leave the later rebinding in place */
+    XCTAssertTrue([[PLPatchMaster master] restoreSymbol: @"_CFGetRetainCount" fromImage: kPLPatchImageCoreFoundation]);
+    XCTAssertEqual(0xFAFA, CFGetRetainCount((__bridge CFTypeRef) [NSArray array]));
+
+    /* Removing the remaining rebinding must restore the original binding */
+    XCTAssertTrue([[PLPatchMaster master] restoreSymbol: @"_CFGetRetainCount"]);
+    XCTAssertEqual(original, CFGetRetainCount((__bridge CFTypeRef) [NSArray array]));
+}
+
+#if !TARGET_OS_IPHONE
+static CFIndex race_first_CFGetRetainCount (CFTypeRef ref) {
+    return 0xA1A1;
+}
+
+static CFIndex race_second_CFGetRetainCount (CFTypeRef ref) {
+    return 0xB2B2;
+}
+
+- (void) testRebindRacingImageLoad {
+    NSString *bundlePath = [[NSBundle bundleForClass: [self class]] pathForResource: @"PLPatchMasterBindFixture" ofType: @"bundle"];
+    NSString *imagePath = [[NSBundle bundleWithPath: bundlePath] executablePath];
+    XCTAssertNotNil(imagePath);
+    
+    NSArray *importers = @[imagePath];
+    for (NSUInteger i = 0; i < 100; i++) {
+        [[PLPatchMaster master] rebindSymbol: @"_CFGetRetainCount" fromImage: kPLPatchImageCoreFoundation replacementAddress: (uintptr_t) race_first_CFGetRetainCount importers: importers];
+        
+        /* Register a newer rebinding while the fixture is being loaded (and rebound from a possibly stale snapshot) */
+        dispatch_group_t group = dispatch_group_create();
+        dispatch_group_async(group, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+            [[PLPatchMaster master] rebindSymbol: @"_CFGetRetainCount" fromImage: kPLPatchImageCoreFoundation replacementAddress: (uintptr_t) race_second_CFGetRetainCount importers: importers];
+        });
+        
+        void *handle = dlopen([imagePath fileSystemRepresentation], RTLD_NOW | RTLD_LOCAL);
+        dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+        XCTAssertTrue(handle != NULL, @"Failed to load fixture: %s", dlerror());
+        
+        /* Regardless of ordering, the newer rebinding must be the one left in place */
+        CFIndex (*getRetainCount)(CFTypeRef) = (CFIndex (*)(CFTypeRef)) dlsym(handle, "PLPatchMasterBindFixtureGetRetainCount");
+        XCTAssertTrue(getRetainCount != NULL);
+        XCTAssertEqual(0xB2B2, getRetainCount((__bridge CFTypeRef) [NSArray array]), @"Stale rebinding written after a newer rebinding");
+        
+        XCTAssertTrue([[PLPatchMaster master] restoreSymbol: @"_CFGetRetainCount" fromImage: kPLPatchImageCoreFoundation]);
+        dlclose(handle);
+    }
+}
+
+- (void) testUnloadFromImageLoadQueue {
+    NSString *bundlePath = [[NSBundle bundleForClass: [self class]] pathForResource: @"PLPatchMasterBindFixture" ofType: @"bundle"];
+    NSString *imagePath = [[NSBundle bundleWithPath: bundlePath] executablePath];
+    XCTAssertNotNil(imagePath);
+    
+    /* Unload the fixture from the image filter predicate, while its batch is being processed */
+    __block void *handle = NULL;
+    __block BOOL unloaded = NO;
+    dispatch_semaphore_t loaded = dispatch_semaphore_create(0);
+    
+    PLPatchImageFilter *filter = [PLPatchImageFilter filter];
+    [filter setPredicate: ^BOOL (NSString *path) {
+        if ([path isEqualToString: imagePath] && !unloaded) {
+            dispatch_semaphore_wait(loaded, DISPATCH_TIME_FOREVER);
+            dlclose(handle);
+            unloaded = YES;
+        }
+        return YES;
+    }];
+    
+    [[PLPatchMaster master] setImageFilter: filter];
+    [[PLPatchMaster master] setBatchImageLoads: YES];
+    
+    handle = dlopen([imagePath fileSystemRepresentation], RTLD_NOW | RTLD_LOCAL);
+    XCTAssertTrue(handle != NULL, @"Failed to load fixture: %s", dlerror());
+    dispatch_semaphore_signal(loaded);
+    
+    /* This will deadlock if the unload waits on the image load queue */
+    [[PLPatchMaster master] flushImageLoads];
+    XCTAssertTrue(unloaded);
+    
+    [[PLPatchMaster master] setBatchImageLoads: NO];
+    [[PLPatchMaster master] setImageFilter: nil];
+#if !__has_feature(objc_arc)
+    dispatch_release(loaded);
+#endif
+}
+#endif /* !TARGET_OS_IPHONE */
+
+- (NSString *) patchSetTargetWithArgument: (NSString *) expected {
+    return expected;
+}
+
+- (NSString *) patchSetRollbackTargetWithArgument: (NSString *) expected {
+    return expected;
+}
+
+static CFIndex patchset_CFGetRetainCount (CFTypeRef ref) {
+    return 0xBAAB;
+}
+
+- (void) testPatchSet {
+    CFIndex (*orig)(CFTypeRef) = &CFGetRetainCount;
+
+    PLPatchSet *patchSet = [[PLPatchSet alloc] init];
+    [patchSet patchInstancesWithClass: [PLPatchMasterTests class] selector: @selector(patchSetTargetWithArgument:) replacementBlock: ^(PLPatchIMP *patch, NSString *expected) {
+        NSString *originalResult = PLPatchIMPFoward(patch, NSString *(*)(id, SEL, NSString *), expected);
+        return [NSString stringWithFormat: @"[PATCHED]: %@", originalResult];
+    }];
+    [patchSet rebindSymbol: @"_CFGetRetainCount" fromImage: kPLPatchImageCoreFoundation replacementAddress: (uintptr_t) patchset_CFGetRetainCount];
+
+    XCTAssertTrue([[PLPatchMaster master] applyPatchSet: patchSet]);
+    XCTAssertEqualObjects(@"[PATCHED]: Result", [self patchSetTargetWithArgument: @"Result"], @"Incorrect value returned");
+    XCTAssertEqual(0xBAAB, CFGetRetainCount((__bridge CFTypeRef) [NSArray array]));
+
+    /* Restore the original */
+    [[PLPatchMaster master] rebindSymbol: @"_CFGetRetainCount" fromImage: kPLPatchImageCoreFoundation replacementAddress: (uintptr_t) orig];
+}
+
+- (void) testPatchSetRollback {
+    PLPatchSet *patchSet = [[PLPatchSet alloc] init];
+    [patchSet patchInstancesWithClass: [PLPatchMasterTests class] selector: @selector(patchSetRollbackTargetWithArgument:) replacementBlock: ^(PLPatchIMP *patch, NSString *expected) {
+        return @"[PATCHED]";
+    }];
+    [patchSet rebindSymbol: @"_CFGetRetainCount" fromImage: kPLPatchImageCoreFoundation replacementAddress: (uintptr_t) patchset_CFGetRetainCount];
+
+    /* An undefined method must cause the entire set to be rejected */
+    [patchSet patchInstancesWithClass: [PLPatchMasterTests class] selector: NSSelectorFromString(@"undefinedPatchSetTarget") replacementBlock: ^(PLPatchIMP *patch) {}];
+
+    XCTAssertFalse([[PLPatchMaster master] applyPatchSet: patchSet]);
+    XCTAssertEqualObjects(@"Result", [self patchSetRollbackTargetWithArgument: @"Result"], @"Patch was not rolled back");
+    XCTAssertNotEqual(0xBAAB, CFGetRetainCount((__bridge CFTypeRef) [NSArray array]));
+}
+
+- (void) testPatchSetRollbackAfterRebinding {
+    /* Register an existing rebinding; rolling back the set must restore it, rather than the original binding */
+    [[PLPatchMaster master] rebindSymbol: @"_CFGetRetainCount" fromImage: kPLPatchImageCoreFoundation replacementAddress: (uintptr_t) filtered_CFGetRetainCount];
+    XCTAssertEqual(0xFAFA, CFGetRetainCount((__bridge CFTypeRef) [NSArray array]));
+
+    PLPatchSet *patchSet = [[PLPatchSet alloc] init];
+    [patchSet patchInstancesWithClass: [PLPatchMasterTests class] selector: @selector(patchSetRollbackTargetWithArgument:) replacementBlock: ^(PLPatchIMP *patch, NSString *expected) {
+        return @"[PATCHED]";
+    }];
+    [patchSet rebindSymbol: @"_CFGetRetainCount" fromImage: kPLPatchImageCoreFoundation replacementAddress: (uintptr_t) patchset_CFGetRetainCount];
+
+    /* Trampolines are reserved once the bind sites have been rewritten; failing the reservation forces a rollback
+     * from the bind logs */
+    Method reserve = class_getInstanceMethod(NSClassFromString(@"PLPatchMasterImpl"), NSSelectorFromString(@"reserveTrampolines:counts:"));
+    XCTAssertTrue(reserve != NULL);
+    IMP reserveIMP = method_setImplementation(reserve, imp_implementationWithBlock(^BOOL (id impl, void *trampolines, const size_t *counts) {
+        return NO;
+    }));
+
+    XCTAssertFalse([[PLPatchMaster master] applyPatchSet: patchSet]);
+    imp_removeBlock(method_setImplementation(reserve, reserveIMP));
+
+    XCTAssertEqualObjects(@"Result", [self patchSetRollbackTargetWithArgument: @"Result"], @"Patch was not rolled back");
+    XCTAssertEqual(0xFAFA, CFGetRetainCount((__bridge CFTypeRef) [NSArray array]), @"Bind sites were not restored");
+
+    XCTAssertTrue([[PLPatchMaster master] restoreSymbol: @"_CFGetRetainCount" fromImage: kPLPatchImageCoreFoundation]);
+}
+
 #if !defined(__i386__) || (defined(__i386__) && TARGET_OS_IPHONE)
 - (void) testRebindClassSymbol {
     /* This test only works on the ObjC 2.0 runtime; the ObjC 1.0 runtime performs